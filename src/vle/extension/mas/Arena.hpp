@@ -0,0 +1,180 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class Arena
+ *  @brief Monotonic memory pool for short-lived objects
+ *
+ *  An allocation bumps a pointer in the current chunk; nothing is freed
+ *  before reset(), which makes the whole pool available again. When a
+ *  cycle needed several chunks, reset() replaces them by a single chunk
+ *  of their total size, so a steady workload ends up in one chunk.
+ *  Destructors are not run: the objects are destroyed by their owners
+ *  (e.g. a std::vector with an ArenaAllocator) before the reset.
+ */
+class Arena
+{
+public:
+    static const std::size_t cDefaultChunk = 4096;
+
+    explicit Arena(std::size_t chunk = cDefaultChunk)
+    :mCurrent(nullptr), mEnd(nullptr), mChunkSize(chunk)
+    {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /** @brief Uninitialized block of bytes, aligned on align (a power of
+     *         two) */
+    void* allocate(std::size_t bytes,
+                   std::size_t align = alignof(std::max_align_t))
+    {
+        char* p = aligned(mCurrent, align);
+        /* The alignment may already pass the end of the chunk */
+        if (!mCurrent || p > mEnd || bytes > (std::size_t)(mEnd - p)) {
+            grow(bytes + align);
+            p = aligned(mCurrent, align);
+        }
+        mCurrent = p + bytes;
+        return p;
+    }
+
+    /** @brief Make all the memory available again */
+    void reset()
+    {
+        if (mChunks.size() > 1) {
+            std::size_t total = capacity();
+            mChunks.clear();
+            mChunks.push_back(Chunk(total));
+        }
+        if (!mChunks.empty()) {
+            mCurrent = mChunks.back().data.get();
+            mEnd = mCurrent + mChunks.back().size;
+        }
+    }
+
+    /** @brief Bytes reserved by the pool */
+    std::size_t capacity() const
+    {
+        std::size_t total = 0;
+        for (const Chunk& chunk : mChunks)
+            total += chunk.size;
+        return total;
+    }
+
+private:
+    struct Chunk
+    {
+        explicit Chunk(std::size_t s)
+        :data(new char[s]), size(s)
+        {}
+
+        std::unique_ptr<char[]> data;
+        std::size_t             size;
+    };
+
+    static inline char* aligned(char* p, std::size_t align)
+    {
+        std::uintptr_t u = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<char*>((u + align - 1) & ~(align - 1));
+    }
+
+    void grow(std::size_t bytes)
+    {
+        std::size_t size = mChunks.empty() ? mChunkSize
+                                           : 2 * mChunks.back().size;
+        if (size < bytes)
+            size = bytes;
+        mChunks.push_back(Chunk(size));
+        mCurrent = mChunks.back().data.get();
+        mEnd = mCurrent + size;
+    }
+
+private:
+    std::vector<Chunk> mChunks;    /**< reserved memory */
+    char*              mCurrent;   /**< first free byte of the last chunk */
+    char*              mEnd;       /**< end of the last chunk */
+    std::size_t        mChunkSize; /**< size of the first chunk */
+};
+
+/** @class ArenaAllocator
+ *  @brief Standard allocator drawing from an Arena
+ *
+ *  deallocate() does nothing: the memory comes back on Arena::reset(), so
+ *  a container using it must not outlive the cycle of the arena.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena& arena)
+    :mArena(&arena)
+    {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+    :mArena(other.arena())
+    {}
+
+    inline T* allocate(std::size_t n)
+    {return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));}
+
+    inline void deallocate(T*, std::size_t)
+    {}
+
+    inline Arena* arena() const
+    {return mArena;}
+
+private:
+    Arena* mArena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{return a.arena() == b.arena();}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{return a.arena() != b.arena();}
+
+/** @brief Vector living in an Arena */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+}
+}
+}// namespace vle extension mas
+
+#endif
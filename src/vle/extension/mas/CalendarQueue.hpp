@@ -0,0 +1,351 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CALENDAR_QUEUE_HPP
+#define CALENDAR_QUEUE_HPP
+
+#include <vle/devs/Time.hpp>
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace vd = vle::devs;
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class CalendarQueue
+ *  @brief Calendar queue of scheduler handles (R. Brown, 1988)
+ *
+ *  Keys are spread over an array of buckets ("days") of fixed width; a
+ *  bucket holds every key of its day for all the "years". Push, update and
+ *  erase are O(1); the minimum is found by walking the days from the last
+ *  dequeued key, which is O(1) on average when the width matches the key
+ *  distribution. The number of buckets follows the queue size and the width
+ *  is re-estimated from the smallest keys on each resize.
+ *
+ *  Infinite keys are kept apart and only returned when no finite key is
+ *  left.
+ */
+class CalendarQueue
+{
+public:
+    typedef std::size_t Handle;
+    typedef vd::Time    Key;
+
+    CalendarQueue()
+    :mBuckets(cMinBuckets), mWidth(1.0), mStart(0.0), mFinite(0),
+     mTop(npos)
+    {}
+
+    /** @brief Insert a handle with the given key */
+    void push(Handle h, vd::Time key)
+    {
+        if (h >= mEntries.size())
+            mEntries.resize(h + 1);
+        if (mEntries[h].queued)
+            throw std::logic_error("CalendarQueue already contains "
+                                   "this handle");
+        insert(h, key);
+        if (mTop != npos && key < mEntries[mTop].key)
+            mTop = h;
+        if (mFinite > 2 * mBuckets.size())
+            resize(2 * mBuckets.size());
+    }
+
+    /** @brief Change the key of a queued handle */
+    void update(Handle h, vd::Time key)
+    {
+        check(h);
+        extract(h);
+        insert(h, key);
+        if (mTop == h)
+            mTop = npos;
+        else if (mTop != npos && key < mEntries[mTop].key)
+            mTop = h;
+    }
+
+    /** @brief Remove a queued handle */
+    void erase(Handle h)
+    {
+        check(h);
+        extract(h);
+        if (mTop == h)
+            mTop = npos;
+        if (mBuckets.size() > cMinBuckets && mFinite < mBuckets.size() / 2)
+            resize(mBuckets.size() / 2);
+    }
+
+    /** @brief Remove the minimal handle */
+    void pop()
+    {
+        Handle h = top();
+        if (std::isfinite(mEntries[h].key))
+            mStart = mEntries[h].key;
+        erase(h);
+    }
+
+    inline Handle top() const
+    {
+        if (empty())
+            throw std::logic_error("CalendarQueue is empty");
+        if (mTop == npos)
+            mTop = findTop();
+        return mTop;
+    }
+
+    inline vd::Time topKey() const
+    {return mEntries[top()].key;}
+
+    inline bool empty() const
+    {return size() == 0;}
+
+    inline std::size_t size() const
+    {return mFinite + mInfinite.size();}
+
+    /** @brief Replace the key of every queued handle by key(handle) and
+     *         restore the ordering once */
+    template <typename F>
+    void rekey(F key)
+    {
+        std::vector<Handle> handles(mInfinite);
+        for (const std::vector<Handle>& bucket : mBuckets)
+            handles.insert(handles.end(), bucket.begin(), bucket.end());
+        for (std::vector<Handle>& bucket : mBuckets)
+            bucket.clear();
+        mInfinite.clear();
+        mFinite = 0;
+        for (Handle h : handles)
+            insert(h, key(h));
+        mTop = npos;
+        resize(mBuckets.size());
+    }
+
+    inline void clear()
+    {
+        mBuckets.assign(cMinBuckets, std::vector<Handle>());
+        mInfinite.clear();
+        mEntries.clear();
+        mWidth = 1.0;
+        mStart = 0.0;
+        mFinite = 0;
+        mTop = npos;
+    }
+
+    /** @brief Call f(handle) for every handle whose key is not above
+     *         limit */
+    template <typename F>
+    void forEachUntil(vd::Time limit, F f) const
+    {
+        if (empty() || limit < topKey())
+            return;
+        if (mFinite > 0) {
+            /* Only the days between the minimum and limit are visited */
+            vd::Time top = topKey();
+            double days = std::isfinite(limit)
+                          ? yearOf(limit) - yearOf(top) + 1
+                          : mBuckets.size();
+            std::size_t n = days < mBuckets.size() ? (std::size_t)days
+                                                   : mBuckets.size();
+            std::size_t day = bucketOf(top);
+            for (std::size_t i = 0; i < n; ++i) {
+                for (Handle h : mBuckets[day]) {
+                    if (!(limit < mEntries[h].key))
+                        f(h);
+                }
+                day = (day + 1) % mBuckets.size();
+            }
+        }
+        if (!std::isfinite(limit)) {
+            for (Handle h : mInfinite) {
+                if (!(limit < mEntries[h].key))
+                    f(h);
+            }
+        }
+    }
+
+    /** @brief Current bucket width */
+    inline vd::Time width() const
+    {return mWidth;}
+
+    /** @brief Current number of buckets */
+    inline std::size_t buckets() const
+    {return mBuckets.size();}
+
+private:
+    struct Entry
+    {
+        Entry()
+        :key(0.0),position(0),queued(false)
+        {}
+
+        vd::Time    key;
+        std::size_t position; /**< index in its bucket */
+        bool        queued;
+    };
+
+    static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static const std::size_t cMinBuckets = 2;
+    static const std::size_t cSamples = 25;
+
+    inline void check(Handle h) const
+    {
+        if (h >= mEntries.size() || !mEntries[h].queued)
+            throw std::logic_error("CalendarQueue doesn't contain "
+                                   "this handle");
+    }
+
+    inline double yearOf(vd::Time key) const
+    {return std::floor(key / mWidth);}
+
+    inline std::size_t bucketOf(vd::Time key) const
+    {
+        double day = std::fmod(yearOf(key), (double)mBuckets.size());
+        if (day < 0)
+            day += mBuckets.size();
+        return (std::size_t)day;
+    }
+
+    inline std::vector<Handle>& bucketFor(vd::Time key)
+    {return std::isfinite(key) ? mBuckets[bucketOf(key)] : mInfinite;}
+
+    void insert(Handle h, vd::Time key)
+    {
+        Entry& e = mEntries[h];
+        e.key = key;
+        e.queued = true;
+        std::vector<Handle>& bucket = bucketFor(key);
+        e.position = bucket.size();
+        bucket.push_back(h);
+        if (std::isfinite(key)) {
+            if (mFinite == 0 || key < mStart)
+                mStart = key;
+            ++mFinite;
+        }
+    }
+
+    void extract(Handle h)
+    {
+        Entry& e = mEntries[h];
+        std::vector<Handle>& bucket = bucketFor(e.key);
+        Handle last = bucket.back();
+        bucket[e.position] = last;
+        mEntries[last].position = e.position;
+        bucket.pop_back();
+        e.queued = false;
+        if (std::isfinite(e.key))
+            --mFinite;
+    }
+
+    Handle findTop() const
+    {
+        if (mFinite == 0)
+            return mInfinite.front();
+
+        /* Walk one year of days from the last dequeued key */
+        double year = yearOf(mStart);
+        std::size_t day = bucketOf(mStart);
+        for (std::size_t n = 0; n < mBuckets.size(); ++n) {
+            Handle best = npos;
+            for (Handle h : mBuckets[day]) {
+                if (yearOf(mEntries[h].key) <= year
+                    && (best == npos || mEntries[h].key < mEntries[best].key))
+                    best = h;
+            }
+            if (best != npos) {
+                mStart = mEntries[best].key;
+                return best;
+            }
+            day = (day + 1) % mBuckets.size();
+            year += 1;
+        }
+
+        /* Sparse calendar: direct search */
+        Handle best = npos;
+        for (const std::vector<Handle>& bucket : mBuckets) {
+            for (Handle h : bucket) {
+                if (best == npos || mEntries[h].key < mEntries[best].key)
+                    best = h;
+            }
+        }
+        mStart = mEntries[best].key;
+        return best;
+    }
+
+    /* Re-estimate the width from the average gap between the smallest
+     * keys, ignoring the large gaps, then rebuild the buckets */
+    void resize(std::size_t buckets)
+    {
+        std::vector<Handle> handles;
+        handles.reserve(mFinite);
+        for (const std::vector<Handle>& bucket : mBuckets)
+            handles.insert(handles.end(), bucket.begin(), bucket.end());
+
+        std::vector<vd::Time> keys;
+        keys.reserve(handles.size());
+        for (Handle h : handles)
+            keys.push_back(mEntries[h].key);
+        std::size_t samples = keys.size() < cSamples ? keys.size() : cSamples;
+        std::partial_sort(keys.begin(), keys.begin() + samples, keys.end());
+
+        if (samples > 1) {
+            double average = (keys[samples - 1] - keys[0]) / (samples - 1);
+            double sum = 0;
+            std::size_t count = 0;
+            for (std::size_t i = 1; i < samples; ++i) {
+                double gap = keys[i] - keys[i - 1];
+                if (gap <= 2 * average) {
+                    sum += gap;
+                    ++count;
+                }
+            }
+            double width = count > 0 ? 3 * sum / count : 0;
+            if (width > 0 && std::isfinite(width))
+                mWidth = width;
+        }
+
+        mBuckets.assign(buckets, std::vector<Handle>());
+        mFinite = 0;
+        for (Handle h : handles)
+            insert(h, mEntries[h].key);
+        mTop = npos;
+    }
+
+private:
+    std::vector<std::vector<Handle> > mBuckets;  /**< days of the calendar */
+    std::vector<Handle>               mInfinite; /**< handles at infinity */
+    std::vector<Entry>                mEntries;  /**< state of each handle */
+    vd::Time                          mWidth;    /**< width of a day */
+    mutable vd::Time                  mStart;    /**< lower bound of keys */
+    std::size_t                       mFinite;   /**< finite keys count */
+    mutable Handle                    mTop;      /**< cached minimum */
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
@@ -26,10 +26,12 @@
 #ifndef EFFECT_HPP
 #define EFFECT_HPP
 #include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
 #include <vle/devs/Time.hpp>
 #include <vle/value/Value.hpp>
 #include <unordered_map>
 #include <vle/extension/mas/PropertyContainer.hpp>
+#include <vle/extension/mas/Symbol.hpp>
 
 namespace vd = vle::devs;
 namespace vv = vle::value;
@@ -38,6 +40,9 @@ namespace vle {
 namespace extension {
 namespace mas {
 
+template <typename T>
+struct IdentityOf;
+
 /** @class Effect
  *  @brief Describes an effect on agents
  *
@@ -50,7 +55,7 @@ public:
     typedef boost::function<void (const Effect&)> EffectFunction;
 
 public:
-    Effect(const vd::Time& t,const std::string& name,const std::string& origin)
+    Effect(const vd::Time& t,const Symbol& name,const Symbol& origin)
     :mDate(t),mName(name),mOrigin(origin)
     {}
 
@@ -64,9 +69,15 @@ public:
     {return (mDate == d);}
 
     inline const std::string& getName() const
+    {return mName.str();}
+
+    inline const std::string& getOrigin() const
+    {return mOrigin.str();}
+
+    inline const Symbol& getNameSymbol() const
     {return mName;}
 
-    inline std::string getOrigin() const
+    inline const Symbol& getOriginSymbol() const
     {return mOrigin;}
 
     /* Operator overload */
@@ -89,8 +100,19 @@ private:
     Effect();
 private:
     vd::Time     mDate; /**< Date when effect must be applied */
-    std::string  mName; /**< Name of effect */
-    std::string  mOrigin; /**< Origin(model name) of effect */
+    Symbol       mName; /**< Name of effect */
+    Symbol       mOrigin; /**< Origin(model name) of effect */
+};
+
+/** @brief Effects are identified by their name and their origin */
+template <>
+struct IdentityOf<Effect>
+{
+    typedef std::pair<Symbol, Symbol> type;
+    typedef boost::hash<type> hash;
+
+    inline type operator()(const Effect& e) const
+    {return type(e.getNameSymbol(), e.getOriginSymbol());}
 };
 
 }}} //namespace vle extension mas
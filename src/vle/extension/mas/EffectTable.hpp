@@ -0,0 +1,116 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EFFECT_TABLE_HPP
+#define EFFECT_TABLE_HPP
+
+#include <vle/extension/mas/Symbol.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class EffectTable
+ *  @brief Effect methods of an agent class, shared by all its instances
+ *
+ *  Methods are kept sorted by effect name, compared by symbol id, so
+ *  finding the method of an effect is a binary search over the names of
+ *  the class only; the table doesn't grow with the other symbols of the
+ *  process.
+ *
+ *  Also holds the message handlers of the class, with Message as
+ *  EffectType and subjects as names.
+ *
+ *  Every instance of a class must bind the same names, usually in its
+ *  constructor: the table is then complete once the first instance is
+ *  built and later bindings only read it. So find() takes no lock, even
+ *  when simulations run in parallel threads; the mutex only serializes
+ *  the bindings of first instances built concurrently.
+ */
+template <typename Agent, typename EffectType>
+class EffectTable
+{
+public:
+    typedef void (Agent::*Method)(const EffectType&);
+
+    /** @brief The table of the class */
+    static EffectTable& instance()
+    {
+        static EffectTable table;
+        return table;
+    }
+
+    /** @brief Bind name to method; binding it again to the same method,
+     *         as every instance does, changes nothing
+     *  @throw std::logic_error if name is bound to another method */
+    void add(const Symbol& name, Method method)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Method bound = find(name);
+        if (bound == method)
+            return;
+        if (bound)
+            throw std::logic_error(name.str() + " is already bound to "
+                                   "another method");
+        mMethods.insert(std::lower_bound(mMethods.begin(), mMethods.end(),
+                                         name, NameLess()),
+                        Entry(name, method));
+    }
+
+    /** @brief Method of the effect name, nullptr if none */
+    inline Method find(const Symbol& name) const
+    {
+        typename Entries::const_iterator it =
+            std::lower_bound(mMethods.begin(), mMethods.end(), name,
+                             NameLess());
+        return it != mMethods.end() && it->first == name ? it->second
+                                                          : nullptr;
+    }
+
+private:
+    typedef std::pair<Symbol, Method> Entry;
+    typedef std::vector<Entry> Entries;
+
+    struct NameLess
+    {
+        inline bool operator()(const Entry& e, const Symbol& name) const
+        {return e.first < name;}
+    };
+
+    EffectTable()
+    {}
+
+    Entries    mMethods; /**< methods, sorted by name */
+    std::mutex mMutex;   /**< serializes the registrations */
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
@@ -4,16 +4,23 @@ namespace vle {
 namespace extension {
 namespace mas {
 
-const std::string GenericAgent::cOutputPortName = "agent_output";
-const std::string GenericAgent::cInputPortName =  "agent_input";
+const std::string GenericAgentBase::cOutputPortName = "agent_output";
+const std::string GenericAgentBase::cInputPortName =  "agent_input";
+const std::string GenericAgentBase::cStatsPortName = "scheduler_stats";
 
 
-GenericAgent::GenericAgent(const vd::DynamicsInit &init,
-                           const vd::InitEventList &events)
-    :vd::Dynamics(init,events),mCurrentTime(0.0),mState(INIT)
-{ }
+GenericAgentBase::GenericAgentBase(const vd::DynamicsInit &init,
+                                   const vd::InitEventList &events)
+    :vd::Dynamics(init,events),mCurrentTime(0.0),mState(INIT),
+     mShareMessages(true),mName(getModelName()),mHandles(nullptr),
+     mHandle(nullptr)
+{
+    if (events.exist("message_delivery"))
+        mShareMessages = events.get("message_delivery").toString().value()
+                         != "copy";
+}
 
-vd::Time GenericAgent::init(const vd::Time &t)
+vd::Time GenericAgentBase::init(const vd::Time &t)
 {
     mCurrentTime = t;
     switch(mState) {
@@ -33,7 +40,7 @@ vd::Time GenericAgent::init(const vd::Time &t)
     return vd::infinity;
 }
 
-void GenericAgent::internalTransition(const vd::Time &t)
+void GenericAgentBase::internalTransition(const vd::Time &t)
 {
     mCurrentTime = t;
     switch(mState) {
@@ -51,16 +58,18 @@ void GenericAgent::internalTransition(const vd::Time &t)
         case OUTPUT:
             /* remove messages (they have been sent!)*/
             mState = IDLE;
-            mMessagesToSend.clear();
+            mOutbox.clear();
         break;
     }
 
     /* Send all the messages */
-    if(mMessagesToSend.size() > 0)
+    freezeMessages();
+    if(mOutbox.size() > 0)
         mState = OUTPUT;
+    mArena.reset();
 }
 
-vd::Time GenericAgent::timeAdvance() const
+vd::Time GenericAgentBase::timeAdvance() const
 {
     switch(mState) {
         case INIT:
@@ -68,19 +77,21 @@ vd::Time GenericAgent::timeAdvance() const
                                             "in state IDLE : forbidden "\
                                             "state");
         break;
-        case IDLE:
-            if (mScheduler.empty()) {
+        case IDLE: {
+            vd::Time next = nextEffectDate();
+            if (next == vd::infinity) {
                 /* Waiting state */
                 return vd::infinity;
             } else {
                 /* Wake me when next event is ready*/
-                double ta = mScheduler.nextEffect().getDate() - mCurrentTime;
+                double ta = next - mCurrentTime;
                 if (ta < 0) {
                     return 0;
                 } else {
                     return ta;
                 }
             }
+        }
         break;
         case OUTPUT:
             /* Call vle::devs::output */
@@ -92,7 +103,7 @@ vd::Time GenericAgent::timeAdvance() const
     return vd::infinity;
 }
 
-void GenericAgent::output(const vd::Time& /*t*/,
+void GenericAgentBase::output(const vd::Time& /*t*/,
                           vd::ExternalEventList& event_list) const
 {
     switch(mState) {
@@ -107,7 +118,7 @@ void GenericAgent::output(const vd::Time& /*t*/,
     }
 }
 
-void GenericAgent::externalTransition(const vd::ExternalEventList &event_list,
+void GenericAgentBase::externalTransition(const vd::ExternalEventList &event_list,
                                       const vd::Time &t)
 {
     mCurrentTime = t;
@@ -121,47 +132,98 @@ void GenericAgent::externalTransition(const vd::ExternalEventList &event_list,
     }
 
     /* Send all the messages */
-    if(mMessagesToSend.size() > 0)
+    freezeMessages();
+    if(mOutbox.size() > 0)
         mState = OUTPUT;
+    mArena.reset();
+}
+
+vv::Value* GenericAgentBase::observation(
+                                    const vd::ObservationEvent& event) const
+{
+    if (SchedulerStats::enabled && event.onPort(cStatsPortName))
+        return schedulerStats().toValue();
+    return 0;
+}
+
+
+void GenericAgentBase::freezeMessages()
+{
+    for (auto& message : mMessagesToSend) {
+        mOutbox.push_back(std::make_shared<const Message>(std::move(message)));
+    }
+    mMessagesToSend.clear();
 }
 
 
-void GenericAgent::sendMessages(vd::ExternalEventList& event_list) const
+void GenericAgentBase::sendMessages(vd::ExternalEventList& event_list) const
 {
-    for (const auto& messageToSend : mMessagesToSend) {
+    for (const auto& messageToSend : mOutbox) {
         vd::ExternalEvent* DEVS_event = new vd::ExternalEvent(cOutputPortName);
-        for (const auto& p_name : messageToSend.getInformations()) {
-            vv::Value *v = p_name.second.get()->clone();
-            DEVS_event << vd::attribute(p_name.first, v);
+        if (mShareMessages) {
+            DEVS_event << vd::attribute(MessageValue::cAttribute,
+                                        new MessageValue(messageToSend));
+            event_list.push_back(DEVS_event);
+            continue;
+        }
+        for (const auto& p_name : *messageToSend) {
+            vv::Value *v = p_name.second.toValue();
+            DEVS_event << vd::attribute(p_name.first.str(), v);
         }
-        DEVS_event << vd::attribute("sender",messageToSend.getSender());
-        DEVS_event << vd::attribute("receiver",messageToSend.getReceiver());
-        DEVS_event << vd::attribute("subject",messageToSend.getSubject());
+        if (messageToSend->getPayloadSize())
+            DEVS_event << vd::attribute(
+                messageToSend->getPayloadKey().str(),
+                messageToSend->payloadToValue());
+        DEVS_event << vd::attribute("sender",messageToSend->getSender());
+        DEVS_event << vd::attribute("receiver",messageToSend->getReceiver());
+        DEVS_event << vd::attribute("subject",messageToSend->getSubject());
         event_list.push_back(DEVS_event);
     }
 }
 
 
-void GenericAgent::handleExternalEvents(
+void GenericAgentBase::handleExternalEvents(
                                     const vd::ExternalEventList &event_list)
 {
     for (const auto& event : event_list) {
-        if (event->getPortName() == cInputPortName) {
-            std::string receiver = event->getAttributeValue("receiver")
-                                        .toString().value();
-            std::string sender = event->getAttributeValue("sender")
-                                      .toString().value();
-            std::string subject = event->getAttributeValue("subject")
-                                       .toString().value();
-
-            if (receiver == Message::BROADCAST || receiver == getModelName()) {
-                Message incomingM(sender,receiver,subject);
-
-                for (const auto& attribute : event->getAttributes()) {
-                    incomingM.add(attribute.first,attribute.second->clone());
-                }
-                agent_handleEvent(incomingM);
+        if (event->getPortName() != cInputPortName)
+            continue;
+
+        if (event->existAttributeValue(MessageValue::cAttribute)) {
+            const MessageValue* shared = MessageValue::cast(
+                event->getAttributeValue(MessageValue::cAttribute));
+            if (!shared)
+                throw vu::InternalError("Bad message attribute in event "
+                                        "of " + getModelName());
+            if (shared->local()) {
+                const Symbol& receiver = shared->message().getReceiverSymbol();
+                if (receiver == Message::broadcastSymbol() || receiver == mName)
+                    deliver(shared->message());
+            } else {
+                const std::string& receiver = shared->message().getReceiver();
+                if ((receiver == Message::BROADCAST
+                     || receiver == getModelName())
+                    && accepts(shared->message().getSubject()))
+                    deliver(*shared->localMessage());
+            }
+            continue;
+        }
+
+        const std::string& receiver = event->getAttributeValue("receiver")
+                                           .toString().value();
+        const std::string& sender = event->getAttributeValue("sender")
+                                         .toString().value();
+        const std::string& subject = event->getAttributeValue("subject")
+                                          .toString().value();
+
+        if ((receiver == Message::BROADCAST || receiver == getModelName())
+            && accepts(subject)) {
+            Message incomingM(sender,receiver,subject);
+
+            for (const auto& attribute : event->getAttributes()) {
+                incomingM.add(attribute.first,*attribute.second);
             }
+            deliver(incomingM);
         }
     }
 }
@@ -27,14 +27,22 @@
 #define GENERIC_AGENT_HPP
 
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 
 #include <vle/utils/Exception.hpp>
 #include <vle/devs/Dynamics.hpp>
 
+#include <vle/extension/mas/Arena.hpp>
+#include <vle/extension/mas/EffectTable.hpp>
 #include <vle/extension/mas/Scheduler.hpp>
 #include <vle/extension/mas/Message.hpp>
+#include <vle/extension/mas/TypedMessage.hpp>
+#include <vle/extension/mas/MessageValue.hpp>
 #include <vle/extension/mas/Effect.hpp>
+#include <vle/extension/mas/TypedEffect.hpp>
 
 #include <boost/bind.hpp>
 namespace vd = vle::devs;
@@ -48,18 +56,29 @@ namespace extension
 namespace mas
 {
 
-/** @class GenericAgent
+/** @class GenericAgentBase
  *  @brief Generic Agent class
  *  It allows user to create an agent model with 3 functions (agent_init,
  *  agent_dynamic, and agent_handleEvent)
+ *  The effect scheduler is provided by BasicGenericAgent.
+ *  Messages can rather be dispatched on their subject to methods of the
+ *  model (registerHandler).
+ *
+ *  Sent messages are frozen at the end of the transition and each one
+ *  travels as a single shared MessageValue: receivers read the sent
+ *  message itself. The "message_delivery" condition set to "copy" sends
+ *  one attribute per property instead, plus a tuple for a typed payload,
+ *  for models reading the events directly.
  *  @see void agent_dynamic()
  *  @see void agent_init()
  *  @see void agent_handleEvent(const Event&)
+ *  @see BasicGenericAgent
  */
-class GenericAgent : public vd::Dynamics
+class GenericAgentBase : public vd::Dynamics
 {
 public:
-    GenericAgent(const vd::DynamicsInit &init, const vd::InitEventList &events);
+    GenericAgentBase(const vd::DynamicsInit &init,
+                     const vd::InitEventList &events);
 
     /* vle::devs override functions */
     virtual vd::Time init(const vd::Time&);
@@ -68,23 +87,81 @@ public:
     virtual void output(const vd::Time&, vd::ExternalEventList&) const;
     virtual void externalTransition(const vd::ExternalEventList&,
                                     const vd::Time&);
-
-    inline void addEffect(const std::string& name,
-                          const Effect::EffectFunction& f)
-    {mEffectBinder.insert(std::make_pair(name,f));}
-
-    inline void applyEffect(const std::string& name, const Effect& e)
-    {mEffectBinder.at(name)(e);}
+    /** @brief Publish the scheduler counters on the "scheduler_stats" port
+     *  (use a finish view to get them at the end of the run) */
+    virtual vv::Value* observation(const vd::ObservationEvent&) const;
 protected:
     /** @brief Pure virtual agent functions. Modeler must override them */
     virtual void agent_dynamic() = 0;
     /** @brief Pure virtual agent functions. Modeler must override them */
     virtual void agent_init() = 0;
-    /** @brief Pure virtual agent functions. Modeler must override them */
-    virtual void agent_handleEvent(const Message&) = 0;
+    /** @brief Called with the received messages when the agent has no
+     *         registered handler
+     *  @see registerHandler */
+    virtual void agent_handleEvent(const Message&)
+    {}
+
+    /** @brief Handle the messages of subject with a method of the model
+     *         class
+     *
+     *  The method is registered in the table of Agent, shared by all its
+     *  instances. Once an agent has handlers, messages of the other
+     *  subjects are dropped before being decoded and agent_handleEvent()
+     *  is no longer called. The handlers of an agent must all be
+     *  registered from the same class. */
+    template <typename Agent>
+    void registerHandler(const Symbol& subject,
+                         void (Agent::*method)(const Message&))
+    {
+        static_assert(std::is_base_of<GenericAgentBase, Agent>::value,
+                      "message handlers must belong to the agent");
+        if (mHandles && mHandles != &handles<Agent>)
+            throw std::logic_error("Handlers of an agent must be registered "
+                                   "from a single class");
+        EffectTable<Agent, Message>::instance().add(subject, method);
+        mHandles = &handles<Agent>;
+        mHandle = &handle<Agent>;
+    }
 
     /* Utils functions */
-    inline void sendMessage(Message& m) { mMessagesToSend.push_back(m); }
+    inline void sendMessage(const Message& m) { mMessagesToSend.push_back(m); }
+    inline void sendMessage(Message&& m)
+    { mMessagesToSend.push_back(std::move(m)); }
+
+    /** @brief Build a message in the send buffer and return it, to be
+     *         filled before any other message is sent */
+    template <typename... Args>
+    inline Message& emplaceMessage(Args&&... args)
+    {
+        mMessagesToSend.emplace_back(std::forward<Args>(args)...);
+        return mMessagesToSend.back();
+    }
+
+    /** @brief Send a message declared with MAS_MESSAGE, its fields
+     *         stored inline in the message */
+    template <typename T>
+    inline void sendMessage(const Symbol& receiver, const Symbol& subject,
+                            const T& payload)
+    {
+        encodeMessage(payload,
+                      emplaceMessage(mName, receiver, subject));
+    }
+
+    /** @brief Model name, interned once */
+    inline const Symbol& getModelSymbol() const
+    {return mName;}
+
+    /** @brief Date of the next scheduled effect, infinity if none */
+    virtual vd::Time nextEffectDate() const = 0;
+
+    /** @brief Counters of the effect scheduler */
+    virtual SchedulerStats schedulerStats() const = 0;
+
+    /** @brief Pool for the objects of the current transition, reset at
+     *         the end of internalTransition and externalTransition
+     *  @see ArenaVector */
+    inline Arena& transientArena()
+    {return mArena;}
 private:
     /** @brief send all the messages in send buffer */
     void sendMessages(vd::ExternalEventList& event_list) const;
@@ -92,11 +169,44 @@ private:
     /** @brief  Copy external events and calls user function
      *  @see    agent_handleEvent*/
     void handleExternalEvents(const vd::ExternalEventList &event_list);
+
+    /** @brief Move the messages sent by the transition to the outbox */
+    void freezeMessages();
+
+    /** @brief Check if messages of subject are handled, before decoding
+     *         them */
+    inline bool accepts(const Symbol& subject) const
+    {return !mHandles || mHandles(subject);}
+
+    /** @brief Pass message to its handler, or to agent_handleEvent() */
+    inline void deliver(const Message& message)
+    {
+        if (mHandle)
+            mHandle(*this, message);
+        else
+            agent_handleEvent(message);
+    }
+
+    /* Check if Agent has a handler for subject */
+    template <typename Agent>
+    static bool handles(const Symbol& subject)
+    {return EffectTable<Agent, Message>::instance().find(subject) != nullptr;}
+
+    /* Call the handler of Agent for the subject of message, if any */
+    template <typename Agent>
+    static void handle(GenericAgentBase& agent, const Message& message)
+    {
+        typename EffectTable<Agent, Message>::Method method =
+            EffectTable<Agent, Message>::instance().find(
+                message.getSubjectSymbol());
+        if (method)
+            (static_cast<Agent&>(agent).*method)(message);
+    }
 protected:
     static const std::string cOutputPortName;   /**< Agent output port name */
     static const std::string cInputPortName;    /**< Agent input port name */
+    static const std::string cStatsPortName;    /**< Scheduler stats port */
 
-    Scheduler<Effect> mScheduler;    /**< Agent scheduler */
     double           mCurrentTime;  /**< Last known simulation time */
     double           mLastUpdate;   /**< Last time the model had been updated */
 private:
@@ -107,8 +217,162 @@ private:
 
     states             mState;          /**< Agent current state */
     std::vector<Message> mMessagesToSend;   /**< Events to send whith devs::output*/
-    std::unordered_map<std::string,Effect::EffectFunction> mEffectBinder;
+    std::vector<MessageValue::pointer> mOutbox; /**< Frozen messages */
+    bool               mShareMessages;  /**< One shared attribute per event */
+    Symbol             mName;           /**< Model name */
+    bool (*mHandles)(const Symbol&);    /**< handler lookup of the class */
+    void (*mHandle)(GenericAgentBase&, const Message&); /**< handler call */
+    Arena              mArena;          /**< Transient objects */
 };
 
+/** @class BasicGenericAgent
+ *  @brief Generic Agent class with a chosen effect scheduler
+ *
+ *  Models pick the scheduler backend and policies with the template
+ *  parameter, e.g. BasicGenericAgent<Scheduler<Effect, HeapQueue<4> > >.
+ *  The effect type is the element type of the scheduler: Effect, or a
+ *  TypedEffect whose fields are stored inline.
+ *
+ *  Effects are bound to methods of the model class, in a table shared by
+ *  all its instances (addEffect(name, &Model::method)); an instance only
+ *  keeps a pointer to the dispatch function of its class.
+ *  @see GenericAgent
+ */
+template <typename SchedulerT = Scheduler<Effect> >
+class BasicGenericAgent : public GenericAgentBase
+{
+public:
+    typedef SchedulerT EffectScheduler;
+    typedef typename EffectScheduler::value_type EffectType;
+    typedef typename EffectType::EffectFunction EffectFunction;
+
+    BasicGenericAgent(const vd::DynamicsInit &init,
+                      const vd::InitEventList &events)
+    :GenericAgentBase(init, events), mDispatch(nullptr)
+    {}
+
+    /** @brief Bind the effect name to a method of the model class
+     *
+     *  The method is registered in the table of Agent, shared by all its
+     *  instances. The effects of an agent must all be bound from the same
+     *  class, and a name can't be bound to two methods. */
+    template <typename Agent>
+    void addEffect(const Symbol& name,
+                   void (Agent::*method)(const EffectType&))
+    {
+        static_assert(std::is_base_of<BasicGenericAgent, Agent>::value,
+                      "effect methods must belong to the agent");
+        if (mDispatch && mDispatch != &dispatch<Agent>)
+            throw std::logic_error("Effects of an agent must be bound "
+                                   "from a single class");
+        EffectTable<Agent, EffectType>::instance().add(name, method);
+        mDispatch = &dispatch<Agent>;
+    }
+
+    /** @brief Bind the effect name to a function of this instance */
+    void addEffect(const Symbol& name, const EffectFunction& f)
+    {
+        if (!mEffectBinder)
+            mEffectBinder.reset(
+                new std::unordered_map<Symbol, EffectFunction>());
+        mEffectBinder->insert(std::make_pair(name,f));
+    }
+
+    inline void applyEffect(const Symbol& name, const EffectType& e)
+    {
+        if (mDispatch && mDispatch(*this, name, e))
+            return;
+        if (!mEffectBinder)
+            throw std::out_of_range("No function for effect " + name.str());
+        mEffectBinder->at(name)(e);
+    }
+
+protected:
+    virtual vd::Time nextEffectDate() const
+    {return mScheduler.nextDate();}
+
+    virtual SchedulerStats schedulerStats() const
+    {return mScheduler.stats();}
+
+    /** @brief Schedule the effect name of this agent every period, the
+     *         first time phase after the current time
+     *
+     *  The effect is built once: applyNextEffect() re-arms it in place.
+     *  @return Handle of the effect in the scheduler */
+    typename EffectScheduler::Handle schedulePeriodic(const Symbol& name,
+                                                      vd::Time period,
+                                                      vd::Time phase = 0)
+    {
+        return mScheduler.schedulePeriodic(
+                   EffectType(mCurrentTime + phase, name, getModelSymbol()),
+                   period);
+    }
+
+    /** @brief Apply the next effect and remove it from the scheduler, or
+     *         move it to its next period if it is periodic */
+    void applyNextEffect()
+    {
+        if (mScheduler.empty())
+            return;
+
+        typename EffectScheduler::Handle h = mScheduler.nextHandle();
+        if (!mScheduler.periodic(h)) {
+            EffectType effect = mScheduler.popNext();
+            applyEffect(effect.getNameSymbol(), effect);
+            return;
+        }
+        {
+            /* Keeps the effect alive if the function cancels it; released
+             * before the re-arm, so nothing is copied */
+            std::shared_ptr<const EffectType> effect = mScheduler.share(h);
+            applyEffect(effect->getNameSymbol(), *effect);
+        }
+        if (mScheduler.periodic(h))
+            mScheduler.rearm(h);
+    }
+
+    /** @brief Remove all the effects of the next date from the scheduler
+     *         and apply them */
+    void applyNextEffects()
+    {
+        if (mScheduler.empty())
+            return;
+
+        /* The batch lives until the end of the transition */
+        ArenaAllocator<EffectType> allocator(transientArena());
+        ArenaVector<EffectType> effects(allocator);
+        mScheduler.popAllAt(mScheduler.nextKey(), effects);
+        for (const auto& effect : effects) {
+            applyEffect(effect.getNameSymbol(), effect);
+        }
+    }
+
+protected:
+    EffectScheduler mScheduler;    /**< Agent scheduler */
+private:
+    typedef bool (*Dispatch)(BasicGenericAgent&, const Symbol&,
+                             const EffectType&);
+
+    /* Call the method of Agent bound to name, if any */
+    template <typename Agent>
+    static bool dispatch(BasicGenericAgent& agent, const Symbol& name,
+                         const EffectType& e)
+    {
+        typename EffectTable<Agent, EffectType>::Method method =
+            EffectTable<Agent, EffectType>::instance().find(name);
+        if (!method)
+            return false;
+        (static_cast<Agent&>(agent).*method)(e);
+        return true;
+    }
+
+    Dispatch mDispatch; /**< dispatch of the class of the agent */
+    std::unique_ptr<std::unordered_map<Symbol, EffectFunction> >
+             mEffectBinder; /**< functions bound to this instance only */
+};
+
+/** @brief Generic agent with the default effect scheduler */
+typedef BasicGenericAgent<> GenericAgent;
+
 }}} //namespace vle extension mas
 #endif
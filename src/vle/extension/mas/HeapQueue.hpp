@@ -0,0 +1,232 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef HEAP_QUEUE_HPP
+#define HEAP_QUEUE_HPP
+
+#include <vle/devs/Time.hpp>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace vd = vle::devs;
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class HeapQueue
+ *  @brief Indexed d-ary min-heap of scheduler handles
+ *
+ *  Each handle remembers its position in the heap, so a key can be changed
+ *  or removed in O(log n) without searching. Handles are small integers
+ *  allocated by the Scheduler.
+ */
+template <unsigned int D = 4>
+class HeapQueue
+{
+public:
+    typedef std::size_t Handle;
+    typedef vd::Time    Key;
+
+    /** @brief Insert a handle with the given key */
+    void push(Handle h, vd::Time key)
+    {
+        if (h >= mPositions.size())
+            mPositions.resize(h + 1, npos);
+        mHeap.push_back(Node(key, h));
+        mPositions[h] = mHeap.size() - 1;
+        siftUp(mHeap.size() - 1);
+    }
+
+    /** @brief Change the key of a queued handle */
+    void update(Handle h, vd::Time key)
+    {
+        std::size_t i = position(h);
+        vd::Time old = mHeap[i].key;
+        mHeap[i].key = key;
+        if (key < old)
+            siftUp(i);
+        else
+            siftDown(i);
+    }
+
+    /** @brief Remove a queued handle */
+    void erase(Handle h)
+    {
+        std::size_t i = position(h);
+        mPositions[h] = npos;
+        if (i == mHeap.size() - 1) {
+            mHeap.pop_back();
+            return;
+        }
+        vd::Time old = mHeap[i].key;
+        move(mHeap.size() - 1, i);
+        mHeap.pop_back();
+        if (mHeap[i].key < old)
+            siftUp(i);
+        else
+            siftDown(i);
+    }
+
+    /** @brief Remove the minimal handle */
+    void pop()
+    {
+        if (mHeap.empty())
+            throw std::logic_error("HeapQueue is empty");
+        erase(mHeap.front().handle);
+    }
+
+    inline Handle top() const
+    {
+        if (mHeap.empty())
+            throw std::logic_error("HeapQueue is empty");
+        return mHeap.front().handle;
+    }
+
+    inline vd::Time topKey() const
+    {return mHeap.front().key;}
+
+    inline bool empty() const
+    {return mHeap.empty();}
+
+    inline std::size_t size() const
+    {return mHeap.size();}
+
+    /** @brief Replace the key of every queued handle by key(handle) and
+     *         restore the ordering once */
+    template <typename F>
+    void rekey(F key)
+    {
+        for (Node& node : mHeap)
+            node.key = key(node.handle);
+        for (std::size_t i = mHeap.size() / D + 1; i-- > 0;) {
+            if (i < mHeap.size())
+                siftDown(i);
+        }
+    }
+
+    inline void clear()
+    {
+        mHeap.clear();
+        mPositions.clear();
+    }
+
+    /** @brief Call f(handle) for every handle whose key is not above
+     *         limit */
+    template <typename F>
+    void forEachUntil(vd::Time limit, F f) const
+    {
+        if (!mHeap.empty())
+            visitUntil(0, limit, f);
+    }
+
+private:
+    struct Node
+    {
+        Node(vd::Time k, Handle h)
+        :key(k),handle(h)
+        {}
+
+        vd::Time key;
+        Handle   handle;
+    };
+
+    static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    inline std::size_t position(Handle h) const
+    {
+        if (h >= mPositions.size() || mPositions[h] == npos)
+            throw std::logic_error("HeapQueue doesn't contain this handle");
+        return mPositions[h];
+    }
+
+    inline void move(std::size_t from, std::size_t to)
+    {
+        mHeap[to] = mHeap[from];
+        mPositions[mHeap[to].handle] = to;
+    }
+
+    void siftUp(std::size_t i)
+    {
+        Node node = mHeap[i];
+        while (i > 0) {
+            std::size_t parent = (i - 1) / D;
+            if (!(node.key < mHeap[parent].key))
+                break;
+            move(parent, i);
+            i = parent;
+        }
+        mHeap[i] = node;
+        mPositions[node.handle] = i;
+    }
+
+    void siftDown(std::size_t i)
+    {
+        Node node = mHeap[i];
+        const std::size_t n = mHeap.size();
+        for (;;) {
+            std::size_t first = i * D + 1;
+            if (first >= n)
+                break;
+            std::size_t last = std::min(first + D, n);
+            std::size_t best = first;
+            for (std::size_t c = first + 1; c < last; ++c) {
+                if (mHeap[c].key < mHeap[best].key)
+                    best = c;
+            }
+            if (!(mHeap[best].key < node.key))
+                break;
+            move(best, i);
+            i = best;
+        }
+        mHeap[i] = node;
+        mPositions[node.handle] = i;
+    }
+
+    template <typename F>
+    void visitUntil(std::size_t i, vd::Time limit, F& f) const
+    {
+        if (limit < mHeap[i].key)
+            return;
+        f(mHeap[i].handle);
+        std::size_t first = i * D + 1;
+        std::size_t last = std::min(first + D, mHeap.size());
+        for (std::size_t c = first; c < last; ++c)
+            visitUntil(c, limit, f);
+    }
+
+private:
+    std::vector<Node>        mHeap;      /**< d-ary heap of (key, handle) */
+    std::vector<std::size_t> mPositions; /**< heap index of each handle */
+};
+
+template <unsigned int D>
+const std::size_t HeapQueue<D>::npos;
+
+}
+}
+}// namespace vle extension mas
+
+#endif
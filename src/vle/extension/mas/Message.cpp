@@ -1,15 +1,45 @@
 #include <vle/extension/mas/Message.hpp>
+#include <vle/extension/mas/MessageValue.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace vle {
 namespace extension {
 namespace mas {
 
 const std::string Message::BROADCAST = "BROADCAST";
+const std::string MessageValue::cAttribute = "mas_message";
+
+const Symbol& Message::broadcastSymbol()
+{
+    static const Symbol broadcast(BROADCAST);
+    return broadcast;
+}
 
-Message::Message(const std::string& sender,
-                 const std::string& receiver,
-                 const std::string& subject)
-:mSender(sender),mReceiver(receiver),mSubject(subject)
+Message::Message(const Symbol& sender,
+                 const Symbol& receiver,
+                 const Symbol& subject)
+:mSender(sender),mReceiver(receiver),mSubject(subject),mPayloadSize(0),
+ mPayload()
 {}
 
+void Message::setPayload(const Symbol& key, const double* values,
+                         std::size_t size)
+{
+    if (size > cPayloadCapacity)
+        throw std::logic_error("Runtime error(Message): payload "
+                               + key.str() + " has too many fields");
+    mPayloadKey = key;
+    mPayloadSize = size;
+    std::copy(values, values + size, mPayload);
+}
+
+vv::Tuple* Message::payloadToValue() const
+{
+    vv::Tuple* values = vv::Tuple::create(mPayloadSize, 0.0);
+    std::copy(mPayload, mPayload + mPayloadSize, values->value().begin());
+    return values;
+}
+
 }}}//namespace vle extension mas
@@ -26,8 +26,10 @@
 #ifndef MESSAGE_HPP
 #define MESSAGE_HPP
 #include <vle/value/Value.hpp>
+#include <vle/value/Tuple.hpp>
 #include <unordered_map>
 #include <vle/extension/mas/PropertyContainer.hpp>
+#include <vle/extension/mas/Symbol.hpp>
 
 namespace vle {
 namespace extension {
@@ -49,17 +51,52 @@ class Message : public PropertyContainer
 {
 /* Public functions */
 public:
-    Message(const std::string&,const std::string&,const std::string&);
+    Message(const Symbol&,const Symbol&,const Symbol&);
 
-    inline std::string getSender() const
+    inline const std::string& getSender() const
+    {return mSender.str();}
+
+    inline const std::string& getReceiver() const
+    {return mReceiver.str();}
+
+    inline const std::string& getSubject() const
+    {return mSubject.str();}
+
+    inline const Symbol& getSenderSymbol() const
     {return mSender;}
 
-    inline std::string getReceiver() const
+    inline const Symbol& getReceiverSymbol() const
     {return mReceiver;}
 
-    inline std::string getSubject() const
+    /** @brief Subject, to compare with a symbol built once */
+    inline const Symbol& getSubjectSymbol() const
     {return mSubject;}
 
+    /** @brief Store size doubles inline as the payload named key,
+     *         replacing any previous payload */
+    void setPayload(const Symbol& key, const double* values,
+                    std::size_t size);
+
+    /** @brief Fields of the payload named key, nullptr if the message
+     *         carries no such payload of that size */
+    inline const double* getPayload(const Symbol& key,
+                                    std::size_t size) const
+    {
+        return mPayloadSize && mPayloadKey == key && mPayloadSize == size
+            ? mPayload : nullptr;
+    }
+
+    /** @brief Name of the payload, the empty symbol if there is none */
+    inline const Symbol& getPayloadKey() const
+    {return mPayloadKey;}
+
+    inline std::size_t getPayloadSize() const
+    {return mPayloadSize;}
+
+    /** @brief Payload as a new tuple, for the copies that leave the
+     *         message, e.g. the DEVS attributes */
+    vv::Tuple* payloadToValue() const;
+
 /* Private functions */
 private:
     Message();
@@ -68,11 +105,20 @@ private:
 public:
     static const std::string BROADCAST;
 
+    /** @brief Message::BROADCAST as a symbol, built on the first call */
+    static const Symbol& broadcastSymbol();
+
+    /** @brief Maximum number of payload fields, kept inline */
+    static const std::size_t cPayloadCapacity = 8;
+
 /* Private members */
 private:
-    std::string mSender;
-    std::string mReceiver;
-    std::string mSubject;
+    Symbol mSender;
+    Symbol mReceiver;
+    Symbol mSubject;
+    Symbol      mPayloadKey;                 /**< empty without payload */
+    std::size_t mPayloadSize;                /**< number of fields */
+    double      mPayload[cPayloadCapacity];  /**< fields, in order */
 };
 
 }}} //namespace vle extension mas
@@ -0,0 +1,136 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems.
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MESSAGE_VALUE_HPP
+#define MESSAGE_VALUE_HPP
+#include <vle/value/User.hpp>
+#include <vle/extension/mas/Message.hpp>
+#include <vle/extension/mas/Symbol.hpp>
+
+#include <memory>
+#include <ostream>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+namespace vv = vle::value;
+
+/** @class MessageValue
+ *  @brief vv::Value carrying a frozen Message from an agent to others
+ *
+ *  The message is immutable and reference counted, so cloning the value,
+ *  once per receiver, only shares it and every receiver reads the same
+ *  message. Messages coming from a module with another symbol table are
+ *  rebuilt once by local().
+ */
+class MessageValue : public vv::User
+{
+public:
+    typedef std::shared_ptr<const Message> pointer;
+
+    /** @brief Name of the event attribute holding the value */
+    static const std::string cAttribute;
+
+    explicit MessageValue(const pointer& message)
+    :mMessage(message), mDomain(Symbol::domain())
+    {}
+
+    virtual vv::Value* clone() const
+    {return new MessageValue(*this);}
+
+    virtual std::size_t id() const
+    {return cId;}
+
+    virtual std::string name() const
+    {return "vle::extension::mas::Message";}
+
+    virtual void writeFile(std::ostream& out) const
+    {writeString(out);}
+
+    virtual void writeString(std::ostream& out) const
+    {
+        out << "(" << mMessage->getSubject() << "," << mMessage->getSender()
+            << "," << mMessage->getReceiver() << ")";
+    }
+
+    virtual void writeXml(std::ostream& out) const
+    {
+        out << "<string>";
+        writeString(out);
+        out << "</string>";
+    }
+
+    /** @brief Message as sent, its symbols may belong to another module */
+    inline const Message& message() const
+    {return *mMessage;}
+
+    /** @brief Check if the symbols of the message are the ones of this
+     *         module */
+    inline bool local() const
+    {return mDomain == Symbol::domain();}
+
+    /** @brief The message, with symbols of this module */
+    pointer localMessage() const
+    {return local() ? mMessage : pointer(new Message(rebuild(*mMessage)));}
+
+    /** @brief The MessageValue held by v, null if v is something else */
+    static const MessageValue* cast(const vv::Value& v)
+    {
+        if (!v.isUser() || v.toUser().id() != cId)
+            return nullptr;
+        return static_cast<const MessageValue*>(&v.toUser());
+    }
+
+    /** @brief Copy of m whose symbols are interned again from their
+     *         strings */
+    static Message rebuild(const Message& m)
+    {
+        Message copy(m.getSender(), m.getReceiver(), m.getSubject());
+        for (const auto& p : m) {
+            if (p.second.type() == Property::SYMBOL)
+                copy.add(p.first.str(), p.second.getSymbol().str());
+            else
+                copy.add(p.first.str(), Property(p.second));
+        }
+        if (m.getPayloadSize()) {
+            const double* values = m.getPayload(m.getPayloadKey(),
+                                                m.getPayloadSize());
+            copy.setPayload(m.getPayloadKey().str(), values,
+                            m.getPayloadSize());
+        }
+        return copy;
+    }
+
+private:
+    /* Tag of the value among the vv::User types */
+    static const std::size_t cId = 0x4d41534d;
+
+    pointer     mMessage; /**< shared, never modified */
+    const void* mDomain;  /**< symbol table of the sender */
+};
+
+}}} //namespace vle extension mas
+#endif
@@ -24,7 +24,19 @@
 #define PROPERTY_CONTAINER
 
 #include <vle/value/Value.hpp>
-#include <unordered_map>
+#include <vle/value/Double.hpp>
+#include <vle/value/Integer.hpp>
+#include <vle/value/Boolean.hpp>
+#include <vle/value/String.hpp>
+#include <vle/extension/mas/Symbol.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <type_traits>
 
 namespace vle {
 namespace extension {
@@ -32,46 +44,521 @@ namespace mas {
 
 namespace vv = vle::value;
 
+/** @class Property
+ *  @brief Value of a property: a double, an integer, a boolean or a
+ *         symbol stored inline, or any other vv::Value owned by the
+ *         property
+ */
+class Property
+{
+public:
+    enum Type {DOUBLE, INTEGER, BOOLEAN, SYMBOL, VALUE};
+
+    Property()
+    :mType(DOUBLE), mDouble(0.0)
+    {}
+
+    explicit Property(double v)
+    :mType(DOUBLE), mDouble(v)
+    {}
+
+    explicit Property(std::int64_t v)
+    :mType(INTEGER), mInteger(v)
+    {}
+
+    explicit Property(bool v)
+    :mType(BOOLEAN), mBoolean(v)
+    {}
+
+    explicit Property(const Symbol& v)
+    :mType(SYMBOL), mSymbol(v)
+    {}
+
+    /** @brief Unbox the scalar values, clone the other ones */
+    explicit Property(const vv::Value& v)
+    :mType(DOUBLE), mDouble(0.0)
+    {
+        if (!unbox(v)) {
+            mType = VALUE;
+            mValue = v.clone();
+        }
+    }
+
+    /** @brief Unbox the scalar values, keep the other ones */
+    explicit Property(std::unique_ptr<vv::Value> v)
+    :mType(DOUBLE), mDouble(0.0)
+    {
+        if (!unbox(*v)) {
+            mType = VALUE;
+            mValue = v.release();
+        }
+    }
+
+    Property(const Property& other)
+    :mType(DOUBLE), mDouble(0.0)
+    {copy(other);}
+
+    Property(Property&& other) noexcept
+    :mType(DOUBLE), mDouble(0.0)
+    {steal(other);}
+
+    ~Property()
+    {release();}
+
+    Property& operator=(const Property& other)
+    {
+        if (this != &other) {
+            release();
+            copy(other);
+        }
+        return *this;
+    }
+
+    Property& operator=(Property&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    inline Type type() const
+    {return mType;}
+
+    inline double getDouble() const
+    {return mDouble;}
+
+    inline std::int64_t getInteger() const
+    {return mInteger;}
+
+    inline bool getBoolean() const
+    {return mBoolean;}
+
+    inline const Symbol& getSymbol() const
+    {return mSymbol;}
+
+    inline const vv::Value& getValue() const
+    {return *mValue;}
+
+    /** @brief New vv::Value holding the property */
+    vv::Value* toValue() const
+    {
+        switch (mType) {
+        case DOUBLE:
+            return vv::Double::create(mDouble);
+        case INTEGER:
+            return vv::Integer::create(mInteger);
+        case BOOLEAN:
+            return vv::Boolean::create(mBoolean);
+        case SYMBOL:
+            return vv::String::create(mSymbol.str());
+        case VALUE:
+            break;
+        }
+        return mValue->clone();
+    }
+
+private:
+    /* Store v if it is a scalar */
+    bool unbox(const vv::Value& v)
+    {
+        if (v.isDouble()) {
+            mDouble = v.toDouble().value();
+        } else if (v.isInteger()) {
+            mType = INTEGER;
+            mInteger = v.toInteger().value();
+        } else if (v.isBoolean()) {
+            mType = BOOLEAN;
+            mBoolean = v.toBoolean().value();
+        } else if (v.isString()) {
+            mType = SYMBOL;
+            new (&mSymbol) Symbol(v.toString().value());
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /* *this must be empty: released or just built */
+    void copy(const Property& other)
+    {
+        if (other.mType == VALUE) {
+            mType = VALUE;
+            mValue = other.mValue->clone();
+        } else {
+            assign(other);
+        }
+    }
+
+    /* Same as copy, other is left empty */
+    void steal(Property& other)
+    {
+        assign(other);
+        if (other.mType == VALUE) {
+            other.mType = DOUBLE;
+            other.mDouble = 0.0;
+        }
+    }
+
+    void assign(const Property& other)
+    {
+        mType = other.mType;
+        switch (mType) {
+        case DOUBLE:
+            mDouble = other.mDouble;
+            break;
+        case INTEGER:
+            mInteger = other.mInteger;
+            break;
+        case BOOLEAN:
+            mBoolean = other.mBoolean;
+            break;
+        case SYMBOL:
+            new (&mSymbol) Symbol(other.mSymbol);
+            break;
+        case VALUE:
+            mValue = other.mValue;
+            break;
+        }
+    }
+
+    inline void release()
+    {
+        if (mType == VALUE)
+            delete mValue;
+        mType = DOUBLE;
+        mDouble = 0.0;
+    }
+
+    Type mType;
+    union {
+        double       mDouble;
+        std::int64_t mInteger;
+        bool         mBoolean;
+        Symbol       mSymbol;
+        vv::Value*   mValue;   /**< owned */
+    };
+};
+
+/** @class PropertyContainer
+ *  @brief Small set of named properties
+ *
+ *  Properties are kept sorted by key in a flat array, inline up to
+ *  cInlineCapacity entries and on the heap beyond (the inline entries are
+ *  only built when used), so messages and effects carrying a few scalar
+ *  values don't allocate and a lookup is a short binary search over
+ *  contiguous memory. find, getDouble and tryGet read in place; get builds
+ *  a new vv::Value.
+ *
+ *  The inline entries are reserved in every container: with 12 entries of
+ *  24 bytes a container takes about 320 bytes, so an Effect or a Message
+ *  is over 300 bytes even without properties, and each copy moves that
+ *  much. 12 covers the 4 to 11 properties of the effects and messages of
+ *  the models; larger sets spill to the heap.
+ */
 class PropertyContainer
 {
 /* Public types */
 public:
     typedef std::shared_ptr<vv::Value> value_ptr;
-    typedef std::unordered_map<std::string, value_ptr> property_map;
+
+    struct Entry
+    {
+        explicit Entry(const Symbol& key)
+        :first(key)
+        {}
+
+        Symbol   first;  /**< key */
+        Property second; /**< value */
+    };
+
+    typedef const Entry* const_iterator;
+
+    static const std::size_t cInlineCapacity = 12;
 
 /* Public functions */
 public:
-    inline void add(const std::string &t, vv::Value * && v)
-    {add(t, value_ptr(v)); }
+    PropertyContainer()
+    :mSize(0)
+    {}
+
+    PropertyContainer(const PropertyContainer& other)
+    :mHeap(other.mHeap), mSize(other.mSize)
+    {
+        if (mHeap.empty())
+            std::uninitialized_copy(other.begin(), other.end(), inlineData());
+    }
 
-    inline bool exists(const std::string &title) const
-    {return (mInformations.find(title) != mInformations.end());}
+    PropertyContainer(PropertyContainer&& other) noexcept
+    :mSize(0)
+    {steal(other);}
 
-    void add(const std::string &t, const value_ptr &v)
+    ~PropertyContainer()
+    {clear();}
+
+    PropertyContainer& operator=(const PropertyContainer& other)
+    {
+        if (this != &other) {
+            clear();
+            mHeap = other.mHeap;
+            if (mHeap.empty())
+                std::uninitialized_copy(other.begin(), other.end(),
+                                        inlineData());
+            mSize = other.mSize;
+        }
+        return *this;
+    }
+
+    PropertyContainer& operator=(PropertyContainer&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            steal(other);
+        }
+        return *this;
+    }
+
+    /* Keys are symbols, strings are interned on the fly */
+    inline void add(const Symbol &t, double v)
+    {slot(t) = Property(v);}
+
+    inline void add(const Symbol &t, int v)
+    {slot(t) = Property((std::int64_t)v);}
+
+    inline void add(const Symbol &t, std::int64_t v)
+    {slot(t) = Property(v);}
+
+    /* Only for bool: pointers would convert to it */
+    template <typename B>
+    inline typename std::enable_if<std::is_same<B, bool>::value>::type
+    add(const Symbol &t, B v)
+    {slot(t) = Property(v);}
+
+    /** @brief Add a string property, stored as a symbol */
+    inline void add(const Symbol &t, const Symbol& v)
+    {slot(t) = Property(v);}
+
+    inline void add(const Symbol &t, const std::string& v)
+    {slot(t) = Property(Symbol(v));}
+
+    inline void add(const Symbol &t, const char* v)
+    {slot(t) = Property(Symbol(v));}
+
+    /** @brief Add a value, unboxed if it is a scalar, cloned otherwise */
+    inline void add(const Symbol &t, const vv::Value& v)
+    {slot(t) = Property(v);}
+
+    /** @brief Add a value, taking its ownership */
+    inline void add(const Symbol &t, vv::Value * && v)
+    {add(t, std::unique_ptr<vv::Value>(v));}
+
+    inline void add(const Symbol &t, std::unique_ptr<vv::Value> v)
+    {slot(t) = Property(std::move(v));}
+
+    /** @brief Add a property, moved in */
+    inline void add(const Symbol &t, Property&& v)
+    {slot(t) = std::move(v);}
+
+    inline void add(const Symbol &t, const value_ptr &v)
+    {add(t, *v);}
+
+    inline bool exists(const Symbol &title) const
+    {return lookup(title) != end();}
+
+    /** @brief Property of a key, nullptr if it is missing */
+    inline const Property* find(const Symbol& key) const
+    {
+        const_iterator it = lookup(key);
+        return it != end() ? &it->second : nullptr;
+    }
+
+    /** @brief Numeric property as a double, throws if it is missing */
+    double getDouble(const Symbol& key) const
+    {
+        double v;
+        if (!tryGet(key, v))
+            missing(key);
+        return v;
+    }
+
+    /** @brief String property, throws if it is missing */
+    const Symbol& getSymbol(const Symbol& key) const
+    {
+        const Property* p = find(key);
+        if (!p || p->type() != Property::SYMBOL)
+            missing(key);
+        return p->getSymbol();
+    }
+
+    /* Borrowed reads: false if the key is missing or holds another type,
+     * nothing is allocated nor thrown */
+    bool tryGet(const Symbol& key, double& v) const
+    {
+        const Property* p = find(key);
+        if (p && p->type() == Property::DOUBLE)
+            v = p->getDouble();
+        else if (p && p->type() == Property::INTEGER)
+            v = (double)p->getInteger();
+        else
+            return false;
+        return true;
+    }
+
+    bool tryGet(const Symbol& key, std::int64_t& v) const
+    {
+        const Property* p = find(key);
+        if (!p || p->type() != Property::INTEGER)
+            return false;
+        v = p->getInteger();
+        return true;
+    }
+
+    bool tryGet(const Symbol& key, bool& v) const
+    {
+        const Property* p = find(key);
+        if (!p || p->type() != Property::BOOLEAN)
+            return false;
+        v = p->getBoolean();
+        return true;
+    }
+
+    bool tryGet(const Symbol& key, Symbol& v) const
+    {
+        const Property* p = find(key);
+        if (!p || p->type() != Property::SYMBOL)
+            return false;
+        v = p->getSymbol();
+        return true;
+    }
+
+    /** @brief Value of a property as a new vv::Value */
+    value_ptr get(const Symbol& p) const
+    {
+        const_iterator it = lookup(p);
+        if (it == end())
+            missing(p);
+        return value_ptr(it->second.toValue());
+    }
+
+    inline std::size_t size() const
+    {return mSize;}
+
+    inline bool empty() const
+    {return mSize == 0;}
+
+    /** @brief Properties in key order */
+    inline const_iterator begin() const
+    {return data();}
+
+    inline const_iterator end() const
+    {return data() + mSize;}
+
+/* Private functions */
+private:
+    typedef std::aligned_storage<sizeof(Entry),
+                                          alignof(Entry)>::type Buffer;
+
+    struct KeyLess
+    {
+        inline bool operator()(const Entry& e, const Symbol& key) const
+        {return e.first < key;}
+    };
+
+    inline const Entry* inlineData() const
+    {return reinterpret_cast<const Entry*>(mInline);}
+
+    inline Entry* inlineData()
+    {return reinterpret_cast<Entry*>(mInline);}
+
+    inline const Entry* data() const
+    {return mHeap.empty() ? inlineData() : mHeap.data();}
+
+    inline Entry* data()
+    {return mHeap.empty() ? inlineData() : mHeap.data();}
+
+    /* Take the properties of other, which is left empty */
+    void steal(PropertyContainer& other)
     {
-        if (exists(t))
-            mInformations.erase(t);
-        mInformations.insert(std::make_pair(t, v));
+        if (other.mHeap.empty()) {
+            Entry* entries = inlineData();
+            for (std::size_t i = 0; i < other.mSize; ++i)
+                new (entries + i) Entry(std::move(other.inlineData()[i]));
+            mSize = other.mSize;
+            other.clear();
+        } else {
+            mHeap.swap(other.mHeap);
+            mSize = other.mSize;
+            other.mSize = 0;
+        }
     }
 
-    value_ptr get(const std::string& p) const
+    void clear()
     {
-        try {
-            return mInformations.at(p);
-        } catch (std::exception e) {
-            std::string txt = e.what();
-            txt = "Runtime error(PropertyContainer): property operation failed";
-            txt += " => key=" + p;
-            throw std::logic_error(txt);
+        if (mHeap.empty()) {
+            Entry* entries = inlineData();
+            for (std::size_t i = 0; i < mSize; ++i)
+                entries[i].~Entry();
         }
+        mHeap.clear();
+        mSize = 0;
+    }
+
+    [[noreturn]] static void missing(const Symbol& key)
+    {
+        std::string txt;
+        txt = "Runtime error(PropertyContainer): property operation failed";
+        txt += " => key=" + key.str();
+        throw std::logic_error(txt);
+    }
+
+    const_iterator lookup(const Symbol& key) const
+    {
+        const_iterator it = std::lower_bound(begin(), end(), key, KeyLess());
+        return (it != end() && it->first == key) ? it : end();
     }
 
-    inline const property_map& getInformations() const
-    {return mInformations;}
+    /* Property of key, inserted in order if it is missing */
+    Property& slot(const Symbol& key)
+    {
+        Entry* entries = data();
+        Entry* it = std::lower_bound(entries, entries + mSize, key,
+                                     KeyLess());
+        std::size_t i = it - entries;
+        if (i < mSize && it->first == key)
+            return it->second;
+
+        if (mHeap.empty() && mSize == cInlineCapacity) {
+            /* Full: every property moves to the heap */
+            mHeap.reserve(2 * cInlineCapacity);
+            for (std::size_t j = 0; j < mSize; ++j) {
+                mHeap.push_back(std::move(entries[j]));
+                entries[j].~Entry();
+            }
+        }
+        if (!mHeap.empty()) {
+            mHeap.insert(mHeap.begin() + i, Entry(key));
+            ++mSize;
+            return mHeap[i].second;
+        }
+        if (i == mSize) {
+            new (entries + i) Entry(key);
+        } else {
+            new (entries + mSize) Entry(std::move(entries[mSize - 1]));
+            std::move_backward(entries + i, entries + mSize - 1,
+                               entries + mSize);
+            entries[i] = Entry(key);
+        }
+        ++mSize;
+        return entries[i].second;
+    }
 
 /* Private members */
 private:
-    property_map mInformations;
+    Buffer             mInline[cInlineCapacity]; /**< first properties,
+                                                      built on demand */
+    std::vector<Entry> mHeap;  /**< all the properties, once too many */
+    std::size_t        mSize;  /**< number of properties */
 };
 
 }
@@ -79,4 +566,3 @@ private:
 }// namespace vle extension mas
 
 #endif
-
@@ -0,0 +1,304 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RADIX_HEAP_QUEUE_HPP
+#define RADIX_HEAP_QUEUE_HPP
+
+#include <vle/extension/mas/Tick.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class RadixHeapQueue
+ *  @brief Monotone radix heap of scheduler handles, on Tick keys
+ *
+ *  A key lives in the bucket of the highest bit in which it differs from
+ *  the last removed minimum, so bucket 0 holds the keys equal to it. When
+ *  the minimum is removed, only the first non empty bucket is spread over
+ *  the lower ones: each key moves down at most 64 times over its life,
+ *  push and update are O(1) and removing the minimum is amortized O(1).
+ *
+ *  The queue is meant for monotone streams, where no key is set below the
+ *  last removed minimum. Such a key is still accepted, but costs a rebuild
+ *  of the whole queue.
+ */
+class RadixHeapQueue
+{
+public:
+    typedef std::size_t Handle;
+    typedef Tick        Key;
+
+    RadixHeapQueue()
+    :mLast(0), mSize(0), mTop(npos)
+    {}
+
+    /** @brief Insert a handle with the given key */
+    void push(Handle h, Tick key)
+    {
+        if (h >= mEntries.size())
+            mEntries.resize(h + 1);
+        if (mEntries[h].queued)
+            throw std::logic_error("RadixHeapQueue already contains "
+                                   "this handle");
+        if (key < mLast)
+            rebase(key);
+        insert(h, key);
+        if (mTop != npos && key < mEntries[mTop].key)
+            mTop = h;
+    }
+
+    /** @brief Change the key of a queued handle */
+    void update(Handle h, Tick key)
+    {
+        check(h);
+        extract(h);
+        if (key < mLast)
+            rebase(key);
+        insert(h, key);
+        if (mTop == h)
+            mTop = npos;
+        else if (mTop != npos && key < mEntries[mTop].key)
+            mTop = h;
+    }
+
+    /** @brief Remove a queued handle */
+    void erase(Handle h)
+    {
+        check(h);
+        bool minimum = (h == top());
+        extract(h);
+        mTop = npos;
+        if (minimum)
+            advance();
+    }
+
+    /** @brief Remove the minimal handle */
+    void pop()
+    {
+        erase(top());
+    }
+
+    inline Handle top() const
+    {
+        if (empty())
+            throw std::logic_error("RadixHeapQueue is empty");
+        if (mTop == npos)
+            mTop = findTop();
+        return mTop;
+    }
+
+    inline Tick topKey() const
+    {return mEntries[top()].key;}
+
+    inline bool empty() const
+    {return mSize == 0;}
+
+    inline std::size_t size() const
+    {return mSize;}
+
+    /** @brief Replace the key of every queued handle by key(handle) and
+     *         restore the ordering once */
+    template <typename F>
+    void rekey(F key)
+    {
+        std::vector<Handle> handles = detachAll();
+        for (Handle h : handles)
+            mEntries[h].key = key(h);
+        reinsert(handles);
+    }
+
+    inline void clear()
+    {
+        for (std::vector<Handle>& bucket : mBuckets)
+            bucket.clear();
+        mEntries.clear();
+        mLast = 0;
+        mSize = 0;
+        mTop = npos;
+    }
+
+    /** @brief Call f(handle) for every handle whose key is not above
+     *         limit */
+    template <typename F>
+    void forEachUntil(Tick limit, F f) const
+    {
+        /* Buckets hold increasing key ranges: stop at the first one above
+         * limit */
+        for (const std::vector<Handle>& bucket : mBuckets) {
+            bool below = bucket.empty();
+            for (Handle h : bucket) {
+                if (!(limit < mEntries[h].key)) {
+                    f(h);
+                    below = true;
+                }
+            }
+            if (!below)
+                return;
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Entry()
+        :key(0),position(0),bucket(0),queued(false)
+        {}
+
+        Tick          key;
+        std::size_t   position; /**< index in its bucket */
+        unsigned char bucket;
+        bool          queued;
+    };
+
+    static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static const unsigned int cBuckets = 65;
+
+    inline void check(Handle h) const
+    {
+        if (h >= mEntries.size() || !mEntries[h].queued)
+            throw std::logic_error("RadixHeapQueue doesn't contain "
+                                   "this handle");
+    }
+
+    inline unsigned int bucketOf(Tick key) const
+    {return bitWidth(tickBits(key) ^ tickBits(mLast));}
+
+    void insert(Handle h, Tick key)
+    {
+        Entry& e = mEntries[h];
+        e.key = key;
+        e.queued = true;
+        place(h);
+        ++mSize;
+    }
+
+    inline void place(Handle h)
+    {
+        Entry& e = mEntries[h];
+        e.bucket = bucketOf(e.key);
+        e.position = mBuckets[e.bucket].size();
+        mBuckets[e.bucket].push_back(h);
+    }
+
+    void extract(Handle h)
+    {
+        Entry& e = mEntries[h];
+        std::vector<Handle>& bucket = mBuckets[e.bucket];
+        Handle last = bucket.back();
+        bucket[e.position] = last;
+        mEntries[last].position = e.position;
+        bucket.pop_back();
+        e.queued = false;
+        --mSize;
+    }
+
+    inline unsigned int firstBucket() const
+    {
+        unsigned int i = 0;
+        while (mBuckets[i].empty())
+            ++i;
+        return i;
+    }
+
+    Handle findTop() const
+    {
+        const std::vector<Handle>& bucket = mBuckets[firstBucket()];
+        Handle best = bucket.front();
+        for (Handle h : bucket) {
+            if (mEntries[h].key < mEntries[best].key)
+                best = h;
+        }
+        return best;
+    }
+
+    /* Move the reference to the new minimum and spread its bucket over the
+     * lower ones */
+    void advance()
+    {
+        if (empty())
+            return;
+        unsigned int i = firstBucket();
+        if (i == 0)
+            return;
+        mTop = findTop();
+        mLast = mEntries[mTop].key;
+        std::vector<Handle> spread;
+        spread.swap(mBuckets[i]);
+        for (Handle h : spread)
+            place(h);
+        spread.clear();
+        spread.swap(mBuckets[i]);
+    }
+
+    std::vector<Handle> detachAll()
+    {
+        std::vector<Handle> handles;
+        handles.reserve(mSize);
+        for (std::vector<Handle>& bucket : mBuckets) {
+            handles.insert(handles.end(), bucket.begin(), bucket.end());
+            bucket.clear();
+        }
+        return handles;
+    }
+
+    void reinsert(const std::vector<Handle>& handles)
+    {
+        if (!handles.empty()) {
+            mLast = mEntries[handles.front()].key;
+            for (Handle h : handles) {
+                if (mEntries[h].key < mLast)
+                    mLast = mEntries[h].key;
+            }
+        }
+        for (Handle h : handles)
+            place(h);
+        mTop = npos;
+    }
+
+    /* A key below the reference: rebuild the buckets around it */
+    void rebase(Tick key)
+    {
+        std::vector<Handle> handles = detachAll();
+        mLast = key;
+        for (Handle h : handles)
+            place(h);
+    }
+
+private:
+    std::vector<Handle> mBuckets[cBuckets]; /**< buckets by highest bit */
+    std::vector<Entry>  mEntries;           /**< state of each handle */
+    Tick                mLast;              /**< last removed minimum */
+    std::size_t         mSize;              /**< queued handles count */
+    mutable Handle      mTop;               /**< cached minimum */
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems.
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ROUTED_EXECUTIVE_HPP
+#define ROUTED_EXECUTIVE_HPP
+
+#include <vle/devs/Executive.hpp>
+#include <vle/extension/mas/Router.hpp>
+
+#include <string>
+#include <vector>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+namespace vd = vle::devs;
+namespace vp = vle::vpz;
+
+/** @class RoutedExecutive
+ *  @brief Executive whose agents only talk through a Router
+ *
+ *  The executive creates the "router" model with createRouter(), then
+ *  wires each agent it creates with connectAgent(): the agent output goes
+ *  to the router input and the router port named after the agent feeds
+ *  the agent input.
+ *  @see Router
+ */
+class RoutedExecutive : public vd::Executive
+{
+public:
+    RoutedExecutive(const vd::ExecutiveInit& init,
+                    const vd::InitEventList& events)
+    :vd::Executive(init, events)
+    {
+        vp::Dynamic dyn("dynRouter");
+        dyn.setPackage("vle.extension.mas");
+        dyn.setLibrary("Router");
+        dynamics().add(dyn);
+    }
+
+protected:
+    /** @brief Create the router, before connecting any agent */
+    void createRouter()
+    {
+        createModel(cRouterName(),
+                    std::vector<std::string>(1, Router::cInputPortName),
+                    std::vector<std::string>(),
+                    "dynRouter",
+                    std::vector<std::string>(),
+                    "");
+    }
+
+    /** @brief Connect the agent to the router, both ways */
+    void connectAgent(const std::string& agent)
+    {
+        addOutputPort(cRouterName(), agent);
+        addConnection(agent, "agent_output",
+                      cRouterName(), Router::cInputPortName);
+        addConnection(cRouterName(), agent, agent, "agent_input");
+    }
+
+private:
+    static const char* cRouterName()
+    {return "router";}
+};
+
+}}} //namespace vle extension mas
+#endif
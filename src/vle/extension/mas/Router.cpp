@@ -0,0 +1,103 @@
+#include <vle/extension/mas/Router.hpp>
+#include <vle/extension/mas/Message.hpp>
+#include <vle/extension/mas/MessageValue.hpp>
+
+#include <vle/utils/Exception.hpp>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+const std::string Router::cInputPortName = "router_input";
+
+
+Router::Router(const vd::DynamicsInit& init, const vd::InitEventList& events)
+    :vd::Dynamics(init,events)
+{}
+
+vd::Time Router::init(const vd::Time&)
+{
+    return vd::infinity;
+}
+
+vd::Time Router::timeAdvance() const
+{
+    return mPending.empty() ? vd::infinity : 0.0;
+}
+
+void Router::output(const vd::Time& /*t*/,
+                    vd::ExternalEventList& event_list) const
+{
+    const auto& ports = getModel().getOutputPortList();
+
+    for (auto& envelope : mPending) {
+        if (envelope.receiver != Message::BROADCAST) {
+            if (envelope.receiver != envelope.sender
+                && getModel().existOutputPort(envelope.receiver))
+                event_list.push_back(hand(envelope, envelope.receiver));
+            continue;
+        }
+        for (const auto& port : ports) {
+            if (port.first != envelope.sender)
+                event_list.push_back(forward(envelope, port.first));
+        }
+    }
+}
+
+void Router::internalTransition(const vd::Time&)
+{
+    mPending.clear();
+}
+
+void Router::externalTransition(const vd::ExternalEventList& event_list,
+                                const vd::Time&)
+{
+    for (const auto& event : event_list) {
+        if (event->getPortName() != cInputPortName)
+            continue;
+
+        Envelope envelope;
+        if (event->existAttributeValue(MessageValue::cAttribute)) {
+            const MessageValue* shared = MessageValue::cast(
+                event->getAttributeValue(MessageValue::cAttribute));
+            if (!shared)
+                throw vle::utils::InternalError("Bad message attribute "
+                                                "in event of "
+                                                + getModelName());
+            envelope.sender = shared->message().getSender();
+            envelope.receiver = shared->message().getReceiver();
+        } else {
+            envelope.sender = event->getAttributeValue("sender")
+                                   .toString().value();
+            envelope.receiver = event->getAttributeValue("receiver")
+                                     .toString().value();
+        }
+
+        for (const auto& attribute : event->getAttributes()) {
+            envelope.attributes.emplace_back(
+                attribute.first,
+                std::unique_ptr<vv::Value>(attribute.second->clone()));
+        }
+        mPending.push_back(std::move(envelope));
+    }
+}
+
+vd::ExternalEvent* Router::forward(const Envelope& envelope,
+                                   const std::string& port)
+{
+    vd::ExternalEvent* event = new vd::ExternalEvent(port);
+    for (const auto& attribute : envelope.attributes)
+        event << vd::attribute(attribute.first, attribute.second->clone());
+    return event;
+}
+
+vd::ExternalEvent* Router::hand(Envelope& envelope, const std::string& port)
+{
+    vd::ExternalEvent* event = new vd::ExternalEvent(port);
+    for (auto& attribute : envelope.attributes)
+        event << vd::attribute(attribute.first, attribute.second.release());
+    envelope.attributes.clear();
+    return event;
+}
+
+}}} //namespace vle extension mas
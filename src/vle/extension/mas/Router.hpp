@@ -0,0 +1,98 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems.
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include <vle/devs/Dynamics.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+namespace vd = vle::devs;
+namespace vv = vle::value;
+
+/** @class Router
+ *  @brief Mailbox delivering the messages of the agents to their receiver
+ *
+ *  Every agent_output is connected to the router input and the router has
+ *  one output port per agent, named after it and connected to its
+ *  agent_input. A message is only forwarded to the port of its receiver;
+ *  a Message::BROADCAST one goes to every port but the sender's. Messages
+ *  to an unknown agent are dropped.
+ *
+ *  Both the shared MessageValue events and the "copy" ones are routed.
+ *  The router forwards what it received in the next instant, at the same
+ *  date. The attributes are copied once on receipt; a unicast message
+ *  passes that copy on, a broadcast one is copied again for each port.
+ */
+class Router : public vd::Dynamics
+{
+public:
+    /** @brief Name of the port receiving the messages of the agents */
+    static const std::string cInputPortName;
+
+    Router(const vd::DynamicsInit& init, const vd::InitEventList& events);
+
+    virtual vd::Time init(const vd::Time&);
+    virtual vd::Time timeAdvance() const;
+    virtual void output(const vd::Time&, vd::ExternalEventList&) const;
+    virtual void internalTransition(const vd::Time&);
+    virtual void externalTransition(const vd::ExternalEventList&,
+                                    const vd::Time&);
+
+private:
+    typedef std::pair<std::string, std::unique_ptr<vv::Value> > Attribute;
+
+    /* A received message waiting to be forwarded */
+    struct Envelope
+    {
+        std::string            sender;
+        std::string            receiver;
+        std::vector<Attribute> attributes;
+    };
+
+    /** @brief Copy of the envelope attributes on a new event for port */
+    static vd::ExternalEvent* forward(const Envelope& envelope,
+                                      const std::string& port);
+
+    /** @brief The envelope attributes, moved to a new event for port */
+    static vd::ExternalEvent* hand(Envelope& envelope,
+                                   const std::string& port);
+
+private:
+    /** messages of the current instant; the unicast ones are handed over
+     *  by output(), the envelopes are dropped by the next transition */
+    mutable std::vector<Envelope> mPending;
+};
+
+}}} //namespace vle extension mas
+#endif
@@ -24,9 +24,22 @@
 #define SCHEDULER_HPP
 
 #include <vle/devs/Dynamics.hpp>
+#include <vle/extension/mas/SortedQueue.hpp>
+#include <vle/extension/mas/HeapQueue.hpp>
+#include <vle/extension/mas/CalendarQueue.hpp>
+#include <vle/extension/mas/RadixHeapQueue.hpp>
+#include <vle/extension/mas/TimingWheelQueue.hpp>
+#include <vle/extension/mas/SchedulerStats.hpp>
+
+#include <boost/iterator/indirect_iterator.hpp>
 
 #include <stdexcept>
 #include <algorithm>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <functional>
 
 namespace vd = vle::devs;
 
@@ -34,94 +47,958 @@ namespace vle {
 namespace extension {
 namespace mas {
 
+/** @brief Date key of a scheduled element: T::getDate() */
+template <typename T, typename Enable = void>
+struct DateOf
+{
+    typedef vd::Time type;
+
+    inline vd::Time operator()(const T& t) const
+    {return t.getDate();}
+
+    static inline vd::Time toTime(vd::Time k)
+    {return k;}
+
+    static inline vd::Time toKey(vd::Time t)
+    {return t;}
+
+    static inline void setDate(T& t, vd::Time k)
+    {t.setDate(k);}
+};
+
+/** @brief Arithmetic elements are their own date key */
+template <typename T>
+struct DateOf<T,
+              typename std::enable_if<std::is_arithmetic<T>::value>::type>
+{
+    typedef T type;
+
+    inline T operator()(const T& t) const
+    {return t;}
+
+    static inline vd::Time toTime(T k)
+    {return k;}
+
+    static inline T toKey(vd::Time t)
+    {return (T)t;}
+
+    static inline void setDate(T& t, T k)
+    {t = k;}
+};
+
+/** @brief Identity of a scheduled element
+ *
+ *  Two elements with the same identity can't be scheduled together. The
+ *  default identity is the element itself; specialize this template to key
+ *  the scheduler index on a cheaper value (see Effect).
+ */
 template <typename T>
+struct IdentityOf
+{
+    typedef T type;
+    typedef std::hash<T> hash;
+
+    inline const T& operator()(const T& t) const
+    {return t;}
+};
+
+/** @brief Simultaneous elements leave the scheduler in queue order */
+struct NoTieBreak
+{
+    static const bool enabled = false;
+
+    template <typename T>
+    inline bool operator()(const T&, const T&) const
+    {return false;}
+};
+
+/** @brief Simultaneous elements leave the scheduler in identity order,
+ *         whatever the backend and the insertion order */
+template <typename T, typename IdentityKey = IdentityOf<T> >
+struct IdentityTieBreak
+{
+    static const bool enabled = true;
+
+    inline bool operator()(const T& a, const T& b) const
+    {return mIdentity(a) < mIdentity(b);}
+
+    IdentityKey mIdentity;
+};
+
+/** @class Scheduler
+ *  @brief Date ordered container of effects
+ *
+ *  The scheduler is configured at compile time by policies:
+ *  - Queue: storage backend ordering the handles, SortedQueue (default),
+ *    HeapQueue<D>, CalendarQueue, RadixHeapQueue or TimingWheelQueue;
+ *  - DateKey: functor giving the key of an element (T::getDate()),
+ *    converting keys from and to dates and setting the date of an element
+ *    (DateOf, TickDateOf);
+ *  - IdentityKey: functor giving the identity of an element, with its
+ *    type and hash (IdentityOf<T>);
+ *  - TieBreak: order of the elements sharing a date (NoTieBreak,
+ *    IdentityTieBreak).
+ *
+ *  Elements are stored in a dense array and ordered by a Queue backend
+ *  working on handles. A handle is returned by addEffect and stays valid until the
+ *  element leaves the scheduler, so it can be used to update or remove the
+ *  element without searching it. Elements are also indexed by their
+ *  identity (see IdentityOf) so exists and update don't scan the storage.
+ *
+ *  Elements dated at infinity are parked out of the queue, in cold storage
+ *  still indexed by identity; they are queued again when they get a finite
+ *  date. They are only returned by nextEffect() and firstElements() when
+ *  nothing else is scheduled. The bundled models cancel their stale
+ *  effects rather than park them, so parking only serves callers keeping
+ *  an element dormant, e.g. with update() or transformAll().
+ *
+ *  Cancelled elements leave the storage at once, but their queue entries
+ *  are kept as tombstones until they reach the top of the queue or until
+ *  their proportion exceeds the compaction threshold.
+ *
+ *  The handles of the elements sharing the next date are maintained on
+ *  each modification, so firstElements() and popAllAt() don't scan the
+ *  queue.
+ *
+ *  A periodic element (schedulePeriodic) keeps its handle and its storage
+ *  when it is due: removeNextEffect() and popAllAt() re-arm it one period
+ *  later instead of removing it, which only moves its handle in the queue.
+ *  One parked at infinity has no next period: it is removed when popped.
+ *
+ *  The storage is copy-on-write: elements() returns a Snapshot in O(1),
+ *  which can be iterated while the scheduler is modified. The first
+ *  modification made while a snapshot is alive copies the array of
+ *  element pointers, never the elements themselves; an element is only
+ *  copied when it is changed in place while shared.
+ */
+template <typename T,
+          typename Queue = SortedQueue,
+          typename DateKey = DateOf<T>,
+          typename IdentityKey = IdentityOf<T>,
+          typename TieBreak = NoTieBreak>
 class Scheduler
 {
+    typedef std::vector<std::shared_ptr<T> > Storage;
+
+    /* Stands for the identity when it is the element itself */
+    struct NoIdentity
+    {};
+
 public:
-    typedef typename std::vector<T> Elements;
-    typedef typename std::vector<T*> FirstElements;
+    /** @class Snapshot
+     *  @brief Read-only view of the elements at the time it was taken, in
+     *         storage order */
+    class Snapshot
+    {
+    public:
+        typedef boost::indirect_iterator<typename Storage::const_iterator,
+                                         const T> const_iterator;
+        typedef const_iterator iterator;
+
+        inline std::size_t size() const
+        {return mStorage->size();}
+
+        inline bool empty() const
+        {return mStorage->empty();}
+
+        inline const T& operator[](std::size_t i) const
+        {return *(*mStorage)[i];}
+
+        inline const_iterator begin() const
+        {return const_iterator(mStorage->begin());}
+
+        inline const_iterator end() const
+        {return const_iterator(mStorage->end());}
+
+    private:
+        friend class Scheduler;
+
+        explicit Snapshot(const std::shared_ptr<const Storage>& storage)
+        :mStorage(storage)
+        {}
+
+        std::shared_ptr<const Storage> mStorage;
+    };
+
+    typedef T value_type;
+    typedef std::size_t Handle;
+    typedef Snapshot Elements;
+    typedef typename std::vector<const T*> FirstElements;
+    typedef typename std::vector<Handle> FirstHandles;
+    typedef typename IdentityKey::type Identity;
+    /** @brief Argument of cancel(identity); unusable when the identity is
+     *         the element, cancel(const T&) is then enough */
+    typedef typename std::conditional<std::is_same<Identity, T>::value,
+                                      NoIdentity, Identity>::type
+        IdentityArgument;
+    typedef typename DateKey::type Key;
+
+    static_assert(std::is_convertible<Key, typename Queue::Key>::value,
+                  "Scheduler date key doesn't match the queue key");
+    static_assert(std::is_integral<Key>::value
+                  || !std::is_integral<typename Queue::Key>::value,
+                  "Integer queues need an integer date key (TickDateOf)");
+
+    Scheduler()
+    :mElements(std::make_shared<Storage>()), mColdCount(0), mSetDate(0),
+     mFirstDate(), mTolerance(), mDead(0), mCompactionThreshold(0.5)
+    {}
 
     /* Modifiers */
-    inline void updateFirstElements()
+    /** @brief Add element
+     *  @return Handle of the new element */
+    inline Handle addEffect(const T& t)
     {
-        if (mElements.empty())
-            throw std::logic_error("Scheduler is empty");
+        if (exists(t))
+            throw std::logic_error("Scheduler already contains this element");
+        return insert(std::make_shared<T>(t));
+    }
 
-        mFirstElements.clear();
+    inline Handle addEffect(T&& t)
+    {
+        if (exists(t))
+            throw std::logic_error("Scheduler already contains this element");
+        return insert(std::make_shared<T>(std::move(t)));
+    }
+
+    /** @brief Add an element built in place from args
+     *  @return Handle of the new element */
+    template <typename... Args>
+    Handle emplace(Args&&... args)
+    {
+        std::shared_ptr<T> entry = std::make_shared<T>(
+                                       std::forward<Args>(args)...);
+        if (exists(*entry))
+            throw std::logic_error("Scheduler already contains this element");
+        return insert(std::move(entry));
+    }
 
-        vd::Time firstTime= nextEffect().getDate();
+    /** @brief Add an element repeated every period, from its date
+     *
+     *  The element stays in the scheduler when it is due: it is moved one
+     *  period later, until it is removed or cancelled.
+     *  @return Handle of the new element */
+    inline Handle schedulePeriodic(const T& t, vd::Time period)
+    {return schedulePeriodic(T(t), period);}
 
-        typename std::vector<T>::iterator it = mElements.begin();
+    Handle schedulePeriodic(T&& t, vd::Time period)
+    {
+        Key k = DateKey::toKey(period);
+        if (!(Key() < k))
+            throw std::logic_error("Scheduler period must be positive");
+        Handle h = addEffect(std::move(t));
+        mPeriods[h] = k;
+        /* Only bound here, so elements without a date setter can still be
+         * scheduled once */
+        mSetDate = &setDateOf;
+        return h;
+    }
 
-        while (it->getDate() == firstTime) {
-            mFirstElements.push_back(&(*it));
-            it++;
+    /** @brief Move a periodic element to its next period
+     *
+     *  An element dated at infinity has no next period: it is removed. */
+    void rearm(Handle h)
+    {
+        if (!periodic(h))
+            throw std::logic_error("Scheduler element isn't periodic");
+        if (atInfinity(keyOf(h))) {
+            remove(h);
+            return;
         }
+        bool first = leaveFirst(h);
+        advance(h);
+        moved(h, first);
+    }
 
+    /** @brief Remove minimal element, or re-arm it if it is periodic */
+    inline void removeNextEffect()
+    {
+        Handle h = nextHandle();
+        if (mPeriods[h] != Key())
+            rearm(h);
+        else
+            remove(h);
     }
 
-    /** @brief Add element*/
-    inline void addEffect(const T& t)
+    /** @brief Remove the next element and return it, moved out of the
+     *         scheduler unless share() or a snapshot still holds it
+     *
+     *  A periodic element is copied and re-armed instead, as by
+     *  removeNextEffect(). */
+    T popNext()
     {
-        if(!exists(t)) {
-            mElements.push_back(t);
-            std::sort(mElements.begin(),mElements.end());
-            updateFirstElements();
-        } else {
-            throw std::logic_error("Scheduler already contains this element");
+        Handle h = nextHandle();
+        if (mPeriods[h] != Key() && !atInfinity(keyOf(h))) {
+            T t(get(h));
+            rearm(h);
+            return t;
         }
+        MAS_SCHEDULER_STAT(++mStats.removes;
+                           if (keyOf(h) == mFirstDate)
+                               mStats.now = DateKey::toTime(mFirstDate));
+        bool first = leaveFirst(h);
+        std::size_t i = mSlots[h];
+        mIndex.erase(mIdentity(element(i)));
+        T t(take(i));
+        removeAt(i);
+        unschedule(h);
+        release(h);
+        settle(first);
+        return t;
     }
 
-    /** @brief Remove minimal element*/
-    inline void removeNextEffect()
+    /** @brief Remove the element of the given handle */
+    inline void remove(Handle h)
     {
-        if (mElements.empty())
-            throw std::logic_error("Scheduler is empty");
-        mElements.erase(mElements.begin());
+        MAS_SCHEDULER_STAT(++mStats.removes;
+                           if (mDate(get(h)) == mFirstDate)
+                               mStats.now = DateKey::toTime(mFirstDate));
+        bool first = leaveFirst(h);
+        detach(h);
+        unschedule(h);
+        release(h);
+        settle(first);
     }
 
-    inline void update(const T& t)
+    /** @brief Remove and return the elements scheduled at date, and the
+     *         ones within the tolerance after it
+     *
+     *  Nothing is removed unless date is the date of the next elements.
+     *  Periodic elements are copied and re-armed instead of removed, unless
+     *  they are dated at infinity.
+     *  @return the removed elements, moved out of the scheduler */
+    std::vector<T> popAllAt(Key date)
     {
-        if (!exists(t))
-            throw std::logic_error("Scheduler doesn't contain this element");
+        std::vector<T> popped;
+        popAllAt(date, popped);
+        return popped;
+    }
+
+    /** @brief Same as popAllAt(date), appending the elements to popped,
+     *         e.g. a vector drawing from an Arena */
+    template <typename Container>
+    void popAllAt(Key date, Container& popped)
+    {
+        if (mFirst.empty() || mFirstDate != date)
+            return;
+
+        if (TieBreak::enabled)
+            std::sort(mFirst.begin(), mFirst.end(), HandleOrder(*this));
+        MAS_SCHEDULER_STAT(mStats.now = DateKey::toTime(date));
+        popped.reserve(popped.size() + mFirst.size());
+        std::size_t periodics = 0;
+        for (Handle h : mFirst) {
+            std::size_t i = slot(h);
+            if (mPeriods[h] != Key() && !atInfinity(keyOf(h))) {
+                popped.push_back(element(i));
+                mFirst[periodics++] = h;
+                continue;
+            }
+            MAS_SCHEDULER_STAT(++mStats.removes);
+            mIndex.erase(mIdentity(element(i)));
+            popped.push_back(take(i));
+            removeAt(i);
+            unschedule(h);
+            release(h);
+        }
+        for (std::size_t p = 0; p < periodics; ++p)
+            advance(mFirst[p]);
+        mFirst.clear();
+        settle(true);
+    }
+
+    /** @brief Cancel the element with the same identity as t
+     *  @return true if an element has been cancelled */
+    inline bool cancel(const T& t)
+    {return cancelIdentity(mIdentity(t));}
+
+    /** @brief Cancel the element with this identity, without building an
+     *         element (e.g. the name and origin of an Effect)
+     *  @return true if an element has been cancelled */
+    inline bool cancel(const IdentityArgument& identity)
+    {return cancelIdentity(identity);}
+
+    /** @brief Cancel every element for which pred returns true
+     *
+     *  pred gets each element once and may read elements(); the ordering is
+     *  restored once at the end.
+     *  @return number of cancelled elements */
+    template <typename Predicate>
+    size_t cancelIf(Predicate pred)
+    {
+        size_t cancelled = 0;
+        for (std::size_t i = size(); i-- > 0;) {
+            if (pred(element(i))) {
+                Handle h = mHandles[i];
+                detach(h);
+                bury(h);
+                ++cancelled;
+            }
+        }
+        MAS_SCHEDULER_STAT(mStats.cancels += cancelled);
+        if (mDead > mCompactionThreshold * mQueue.size())
+            compact();
+        mFirst.clear();
+        settle(true);
+        return cancelled;
+    }
+
+    /** @brief Apply fn to every element and restore the ordering once
+     *
+     *  fn may change the date of the element it gets, not its identity.
+     *  fn can read the other elements with a snapshot released before it
+     *  returns. A snapshot held across the batch (taken before it, or kept
+     *  by fn) makes every element be copied, properties included, before
+     *  fn changes it: the batch then costs a copy of the scheduler.
+     */
+    template <typename Function>
+    void transformAll(Function fn)
+    {
+        if (mDead > 0)
+            compact();
+        for (std::size_t i = 0; i < size(); ++i)
+            fn(writable(i));
+
+        /* Elements moving between the queue and the cold storage */
+        std::vector<Handle> warmed;
+        for (Handle h : mHandles) {
+            if (atInfinity(keyOf(h)) != mCold[h]) {
+                if (mCold[h]) {
+                    warmed.push_back(h);
+                } else {
+                    mQueue.erase(h);
+                    mCold[h] = true;
+                    ++mColdCount;
+                }
+            }
+        }
+        mQueue.rekey([this](Handle h) {return keyOf(h);});
+        for (Handle h : warmed) {
+            mCold[h] = false;
+            --mColdCount;
+            mQueue.push(h, keyOf(h));
+        }
+        MAS_SCHEDULER_STAT(++mStats.rekeys);
+        mFirst.clear();
+        settle(true);
+    }
+
+    /** @brief Set the proportion of tombstones in the queue above which
+     *         they are all removed at once */
+    inline void setCompactionThreshold(double ratio)
+    {mCompactionThreshold = ratio;}
+
+    /** @brief Elements scheduled at most epsilon after the next element
+     *         are handled as simultaneous with it (0 by default)
+     *
+     *  They are returned together by firstElements() and popAllAt(), so
+     *  near-coincident dates are processed in a single transition. */
+    void setTolerance(Key epsilon)
+    {
+        if (epsilon < Key())
+            throw std::logic_error("Scheduler tolerance must be positive");
+        mTolerance = epsilon;
+        mFirst.clear();
+        settle(true);
+    }
+
+    inline Key tolerance() const
+    {return mTolerance;}
 
-        std::replace(mElements.begin(), mElements.end(), t, t);
-        std::sort(mElements.begin(),mElements.end());
-        updateFirstElements();
+    inline void update(const T& t)
+    {update(handle(t), t);}
+
+    inline void update(T&& t)
+    {
+        Handle h = handle(t);
+        update(h, std::move(t));
     }
 
+    /** @brief Replace the element of the given handle */
+    inline void update(Handle h, const T& t)
+    {replace(h, t);}
+
+    inline void update(Handle h, T&& t)
+    {replace(h, std::move(t));}
+
     /* Observers */
     /** @brief Check if scheduler is empty
      *  @return boolean true if empty, false otherwise*/
     inline bool empty()const
-    {return mElements.empty();}
+    {return mElements->empty();}
 
     /** @brief Get number of elements
      *  @return size_t number of elements*/
     inline size_t size() const
-    {return mElements.size();}
+    {return mElements->size();}
+
+    inline bool exists(const T& t) const
+    {return mIndex.find(mIdentity(t)) != mIndex.end();}
+
+    /** @brief Get the handle of the element with the same identity as t */
+    inline Handle handle(const T& t) const
+    {
+        typename Index::const_iterator it = mIndex.find(mIdentity(t));
+        if (it == mIndex.end())
+            throw std::logic_error("Scheduler doesn't contain this element");
+        return it->second;
+    }
+
+    /** @brief Check if a handle refers to an element of the scheduler */
+    inline bool contains(Handle h) const
+    {return h < mSlots.size() && mSlots[h] != npos && mSlots[h] != dead;}
+
+    /** @brief Check if a handle refers to a periodic element */
+    inline bool periodic(Handle h) const
+    {return contains(h) && mPeriods[h] != Key();}
+
+    /** @brief Get number of cancelled entries still in the queue */
+    inline size_t tombstones() const
+    {return mDead;}
+
+    /** @brief Get number of elements parked at infinity, out of the
+     *         queue */
+    inline size_t parked() const
+    {return mColdCount;}
 
-    inline bool exists(const T& t)
-    {return std::find(mElements.begin(),mElements.end(),t) != mElements.end();}
+    /** @brief Handle of the next element */
+    inline Handle nextHandle() const
+    {
+        if (empty())
+            throw std::logic_error("Scheduler is empty");
+        if (TieBreak::enabled && mFirst.size() > 1)
+            return *std::min_element(mFirst.begin(), mFirst.end(),
+                                     HandleOrder(*this));
+        return mQueue.empty() ? mFirst.front() : mQueue.top();
+    }
 
     /* Element access */
     /** @brief Get next elements of scheduler */
     inline const T& nextEffect() const
+    {return element(mSlots[nextHandle()]);}
+
+    /** @brief Key of the next element */
+    inline Key nextKey() const
     {
-        if (mElements.empty())
+        if (empty())
             throw std::logic_error("Scheduler is empty");
-        return mElements.at(0);
+        return mFirstDate;
+    }
+
+    /** @brief Date of the next element, infinity if the scheduler is
+     *         empty */
+    inline vd::Time nextDate() const
+    {
+        return empty() ? vd::infinity
+                                 : DateKey::toTime(mFirstDate);
     }
 
-    const Elements& elements() const {return mElements;}
+    /** @brief Get the element of the given handle */
+    inline const T& get(Handle h) const
+    {return element(slot(h));}
 
-    const FirstElements& firstElements() const {return mFirstElements;}
+    /** @brief Element of the given handle, kept alive by the pointer if
+     *         it leaves the scheduler, in O(1)
+     *
+     *  Unlike elements(), only this element is copied if it is changed in
+     *  place while the pointer is held. */
+    inline std::shared_ptr<const T> share(Handle h) const
+    {return (*mElements)[slot(h)];}
+
+    /** @brief Snapshot of the elements in storage order (not sorted by
+     *         date), in O(1)
+     *
+     *  While it is alive, the first modification of the scheduler copies
+     *  the array of element pointers, O(n), and each element changed in
+     *  place is copied with its properties first; transformAll() then
+     *  copies every element. Keep snapshots for the time of a read, or use
+     *  share() to keep a single element. */
+    Elements elements() const {return Snapshot(mElements);}
+
+    /** @brief Elements sharing the date of the next element, or within the
+     *         tolerance after it, in tie-break order
+     *
+     *  The pointers are valid until the next modification. */
+    FirstElements firstElements() const
+    {
+        FirstElements first;
+        first.reserve(mFirst.size());
+        for (Handle h : mFirst)
+            first.push_back(&element(mSlots[h]));
+        if (TieBreak::enabled)
+            std::sort(first.begin(), first.end(),
+                      [this](const T* a, const T* b) {
+                          return mTieBreak(*a, *b);
+                      });
+        return first;
+    }
+
+    /** @brief Handles of the first elements, in no particular order */
+    const FirstHandles& firstHandles() const {return mFirst;}
+
+    /** @brief Operation counters, only updated when MAS_SCHEDULER_STATS is
+     *         defined */
+    SchedulerStats stats() const
+    {
+        SchedulerStats stats(mStats);
+        stats.tombstones = mDead;
+        stats.infinite = mColdCount;
+        return stats;
+    }
 protected:
 private:
-    Elements mElements;
-    FirstElements mFirstElements;
+    typedef std::unordered_map<Identity, Handle,
+                               typename IdentityKey::hash> Index;
+    typedef void (*DateSetter)(T&, Key);
+
+    struct HandleOrder
+    {
+        HandleOrder(const Scheduler& s)
+        :scheduler(s)
+        {}
+
+        inline bool operator()(Handle a, Handle b) const
+        {return scheduler.mTieBreak(scheduler.get(a), scheduler.get(b));}
+
+        const Scheduler& scheduler;
+    };
+
+    static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static const std::size_t dead = npos - 1;
+
+    /* Cancel the element indexed under identity */
+    bool cancelIdentity(const Identity& identity)
+    {
+        typename Index::const_iterator it = mIndex.find(identity);
+        if (it == mIndex.end())
+            return false;
+
+        Handle h = it->second;
+        MAS_SCHEDULER_STAT(++mStats.cancels);
+        bool first = leaveFirst(h);
+        detach(h);
+        bury(h);
+        if (mDead > mCompactionThreshold * mQueue.size())
+            compact();
+        settle(first);
+        return true;
+    }
+
+    inline const T& element(std::size_t i) const
+    {return *(*mElements)[i];}
+
+    /* Storage to modify, copied first if a snapshot shares it */
+    inline Storage& storage()
+    {
+        if (mElements.use_count() > 1)
+            mElements = std::make_shared<Storage>(*mElements);
+        return *mElements;
+    }
+
+    /* Element to modify in place, copied first if a snapshot shares it */
+    inline T& writable(std::size_t i)
+    {
+        std::shared_ptr<T>& entry = storage()[i];
+        if (entry.use_count() > 1)
+            entry = std::make_shared<T>(*entry);
+        return *entry;
+    }
+
+    /* Element to remove, moved out unless a snapshot shares it */
+    inline T take(std::size_t i)
+    {
+        std::shared_ptr<T>& entry = storage()[i];
+        if (entry.use_count() > 1)
+            return *entry;
+        return std::move(*entry);
+    }
+
+    inline std::size_t slot(Handle h) const
+    {
+        if (!contains(h))
+            throw std::logic_error("Scheduler doesn't contain this handle");
+        return mSlots[h];
+    }
+
+    /* Store and schedule a new element */
+    Handle insert(std::shared_ptr<T>&& entry)
+    {
+        Key date = mDate(*entry);
+        Handle h = allocate(std::move(entry));
+        schedule(h, date);
+        enterFirst(h, date);
+        MAS_SCHEDULER_STAT(++mStats.inserts;
+                           if (size() > mStats.peakSize)
+                               mStats.peakSize = size();
+                           mStats.horizon(DateKey::toTime(date)));
+        return h;
+    }
+
+    /* Replace the element of h by t, copied or moved */
+    template <typename U>
+    void replace(Handle h, U&& t)
+    {
+        std::size_t i = slot(h);
+        bool reindex = !(mIdentity(element(i)) == mIdentity(t));
+        if (reindex && exists(t))
+            throw std::logic_error("Scheduler already contains this element");
+        bool first = leaveFirst(h);
+        if (reindex) {
+            mIndex.erase(mIdentity(element(i)));
+            mIndex.insert(std::make_pair(mIdentity(t), h));
+        }
+        std::shared_ptr<T>& entry = storage()[i];
+        if (entry.use_count() == 1)
+            *entry = std::forward<U>(t);
+        else
+            entry = std::make_shared<T>(std::forward<U>(t));
+        Key date = mDate(*entry);
+        MAS_SCHEDULER_STAT(++mStats.updates;
+                           mStats.horizon(DateKey::toTime(date)));
+        reschedule(h, date);
+        moved(h, first);
+    }
+
+    Handle allocate(std::shared_ptr<T>&& entry)
+    {
+        Handle h;
+        if (mFreeHandles.empty()) {
+            h = mSlots.size();
+            mSlots.push_back(npos);
+            mCold.push_back(false);
+            mPeriods.push_back(Key());
+        } else {
+            h = mFreeHandles.back();
+            mFreeHandles.pop_back();
+        }
+        mSlots[h] = size();
+        mIndex.insert(std::make_pair(mIdentity(*entry), h));
+        storage().push_back(std::move(entry));
+        mHandles.push_back(h);
+        return h;
+    }
+
+    inline void detach(Handle h)
+    {
+        std::size_t i = slot(h);
+        mIndex.erase(mIdentity(element(i)));
+        removeAt(i);
+    }
+
+    /* Move the last element in the freed place to keep storage dense */
+    void removeAt(std::size_t i)
+    {
+        Storage& elements = storage();
+        std::size_t last = elements.size() - 1;
+        if (i != last) {
+            elements[i] = std::move(elements[last]);
+            mHandles[i] = mHandles[last];
+            mSlots[mHandles[i]] = i;
+        }
+        elements.pop_back();
+        mHandles.pop_back();
+    }
+
+    inline void release(Handle h)
+    {
+        mSlots[h] = npos;
+        mPeriods[h] = Key();
+        mFreeHandles.push_back(h);
+    }
+
+    /* Date a periodic element one period later and move its handle; it
+     * must have a finite date */
+    inline void advance(Handle h)
+    {
+        std::size_t i = mSlots[h];
+        mSetDate(writable(i), mDate(element(i)) + mPeriods[h]);
+        reschedule(h, keyOf(h));
+        MAS_SCHEDULER_STAT(++mStats.rearms;
+                           mStats.horizon(DateKey::toTime(keyOf(h))));
+    }
+
+    static void setDateOf(T& t, Key k)
+    {DateKey::setDate(t, k);}
+
+    /* Restore the first elements after h moved, first telling whether h
+     * was one of them */
+    inline void moved(Handle h, bool first)
+    {
+        if (first && mFirst.empty()) {
+            settle(true);
+        } else {
+            settle(false);
+            enterFirst(h, keyOf(h));
+        }
+    }
+
+    inline bool atInfinity(Key k) const
+    {return !(DateKey::toTime(k) < vd::infinity);}
+
+    /* Queue a handle, or park it in the cold storage if it is dated at
+     * infinity */
+    inline void schedule(Handle h, Key k)
+    {
+        if (atInfinity(k)) {
+            mCold[h] = true;
+            ++mColdCount;
+        } else {
+            mQueue.push(h, k);
+        }
+    }
+
+    inline void unschedule(Handle h)
+    {
+        if (mCold[h]) {
+            mCold[h] = false;
+            --mColdCount;
+        } else {
+            mQueue.erase(h);
+        }
+    }
+
+    inline void reschedule(Handle h, Key k)
+    {
+        if (mCold[h] != atInfinity(k)) {
+            unschedule(h);
+            schedule(h, k);
+        } else if (!mCold[h]) {
+            mQueue.update(h, k);
+        }
+    }
+
+    /* Cancel a detached handle: parked ones are released at once, queued
+     * ones become tombstones */
+    inline void bury(Handle h)
+    {
+        if (mCold[h]) {
+            unschedule(h);
+            release(h);
+        } else {
+            mSlots[h] = dead;
+            ++mDead;
+        }
+    }
+
+    /* Last key of the first elements */
+    inline Key windowEnd() const
+    {
+        if (mTolerance == Key()
+            || std::numeric_limits<Key>::max() - mTolerance < mFirstDate)
+            return mFirstDate;
+        return mFirstDate + mTolerance;
+    }
+
+    inline Key keyOf(Handle h) const
+    {return mDate(element(mSlots[h]));}
+
+    inline void enterFirst(Handle h, Key date)
+    {
+        if (mFirst.empty() || date < mFirstDate) {
+            bool any = !mFirst.empty();
+            mFirstDate = date;
+            if (any && mTolerance > Key()) {
+                /* The window moves back: drop the elements now after it */
+                Key end = windowEnd();
+                mFirst.erase(std::remove_if(mFirst.begin(), mFirst.end(),
+                                            [this, end](Handle f) {
+                                                return end < keyOf(f);
+                                            }),
+                             mFirst.end());
+            } else {
+                mFirst.clear();
+            }
+            mFirst.push_back(h);
+        } else if (!(windowEnd() < date)) {
+            mFirst.push_back(h);
+        }
+    }
+
+    inline bool leaveFirst(Handle h)
+    {
+        typename FirstHandles::iterator it = std::find(mFirst.begin(),
+                                                       mFirst.end(), h);
+        if (it == mFirst.end())
+            return false;
+        mFirst.erase(it);
+        /* The head leaves: the window may move forward, collect it again */
+        if (mTolerance > Key() && keyOf(h) == mFirstDate)
+            mFirst.clear();
+        return true;
+    }
+
+    /* Drop the tombstones at the top of the queue and, when the first
+     * elements ran out, collect the ones of the new next date */
+    void settle(bool refill)
+    {
+        while (mDead > 0 && !mQueue.empty()
+               && mSlots[mQueue.top()] == dead) {
+            Handle h = mQueue.top();
+            mQueue.pop();
+            release(h);
+            --mDead;
+        }
+        if (refill && mFirst.empty() && !empty()) {
+            if (!mQueue.empty()) {
+                mFirstDate = keyOf(mQueue.top());
+                mQueue.forEachUntil(windowEnd(), [this](Handle h) {
+                                        if (mSlots[h] != dead)
+                                            mFirst.push_back(h);
+                                    });
+            } else {
+                /* Only parked elements are left */
+                for (Handle h : mHandles) {
+                    if (mCold[h])
+                        mFirst.push_back(h);
+                }
+                mFirstDate = keyOf(mFirst.front());
+            }
+        }
+    }
+
+    void compact()
+    {
+        MAS_SCHEDULER_STAT(++mStats.compactions);
+        for (Handle h = 0; h < mSlots.size(); ++h) {
+            if (mSlots[h] == dead) {
+                mQueue.erase(h);
+                release(h);
+            }
+        }
+        mDead = 0;
+    }
+
+private:
+    std::shared_ptr<Storage> mElements; /**< stored elements */
+    std::vector<Handle> mHandles;       /**< handle of each stored element */
+    std::vector<std::size_t> mSlots;    /**< storage index of each handle */
+    std::vector<Handle> mFreeHandles;   /**< released handles */
+    std::vector<bool>   mCold;          /**< parked state of each handle */
+    std::size_t         mColdCount;     /**< parked elements */
+    std::vector<Key>    mPeriods;       /**< period of each handle, 0 if
+                                             not periodic */
+    DateSetter          mSetDate;       /**< date setter of the periodic
+                                             elements */
+    Queue               mQueue;         /**< date ordering of the handles */
+    Index               mIndex;         /**< handle of each identity */
+    DateKey             mDate;          /**< date key extractor */
+    IdentityKey         mIdentity;      /**< identity extractor */
+    TieBreak            mTieBreak;      /**< order of simultaneous elements */
+    FirstHandles        mFirst;         /**< elements of the next date */
+    Key                 mFirstDate;     /**< date of the first elements */
+    Key                 mTolerance;     /**< simultaneity window */
+    std::size_t         mDead;          /**< tombstones in the queue */
+    double              mCompactionThreshold;
+    SchedulerStats      mStats;         /**< operation counters */
 };
 
+template <typename T, typename Queue, typename DateKey, typename IdentityKey,
+          typename TieBreak>
+const std::size_t Scheduler<T, Queue, DateKey, IdentityKey, TieBreak>::npos;
+template <typename T, typename Queue, typename DateKey, typename IdentityKey,
+          typename TieBreak>
+const std::size_t Scheduler<T, Queue, DateKey, IdentityKey, TieBreak>::dead;
+
 }
 }
 }// namespace vle extension mas
@@ -0,0 +1,136 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SCHEDULER_STATS_HPP
+#define SCHEDULER_STATS_HPP
+
+#include <vle/devs/Time.hpp>
+#include <vle/value/Map.hpp>
+#include <vle/value/Tuple.hpp>
+
+#include <cmath>
+#include <vector>
+
+/* Scheduler instrumentation is only compiled with MAS_SCHEDULER_STATS
+ * defined (cmake -DWITH_SCHEDULER_STATS=ON) */
+#ifdef MAS_SCHEDULER_STATS
+#define MAS_SCHEDULER_STAT(statement) do { statement; } while (0)
+#else
+#define MAS_SCHEDULER_STAT(statement) do {} while (0)
+#endif
+
+namespace vd = vle::devs;
+namespace vv = vle::value;
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class SchedulerStats
+ *  @brief Operation counters of a Scheduler
+ *
+ *  Horizons are the distances between the date given to an element and
+ *  the date of the last element removed at the head of the scheduler. They
+ *  are counted in powers of two: bin 0 holds the null horizons, bin i the
+ *  ones in [2^(i-1+cMinExponent), 2^(i+cMinExponent)) and the last bin the
+ *  larger and infinite ones.
+ */
+struct SchedulerStats
+{
+#ifdef MAS_SCHEDULER_STATS
+    static const bool enabled = true;
+#else
+    static const bool enabled = false;
+#endif
+    static const std::size_t cHorizonBins = 32;
+    static const int cMinExponent = -10;
+
+    SchedulerStats()
+    :inserts(0), updates(0), removes(0), cancels(0), rearms(0),
+     rekeys(0), compactions(0), peakSize(0), tombstones(0), infinite(0),
+     horizons(cHorizonBins, 0), now(0.0)
+    {}
+
+    /** @brief Count the horizon of an element scheduled at date */
+    inline void horizon(vd::Time date)
+    {++horizons[binOf(date - now)];}
+
+    static std::size_t binOf(vd::Time horizon)
+    {
+        if (!(horizon > 0))
+            return 0;
+        if (!std::isfinite(horizon))
+            return cHorizonBins - 1;
+        int bin = std::ilogb(horizon) - cMinExponent + 1;
+        if (bin < 1)
+            return 1;
+        if (bin > (int)cHorizonBins - 1)
+            return cHorizonBins - 1;
+        return bin;
+    }
+
+    /** @brief Counters as a map, with the histogram in "horizons" */
+    vv::Map* toValue() const
+    {
+        vv::Map* map = new vv::Map();
+        map->addDouble("inserts", inserts);
+        map->addDouble("updates", updates);
+        map->addDouble("removes", removes);
+        map->addDouble("cancels", cancels);
+        map->addDouble("rearms", rearms);
+        map->addDouble("rekeys", rekeys);
+        map->addDouble("compactions", compactions);
+        map->addDouble("peak_size", peakSize);
+        map->addDouble("tombstones", tombstones);
+        map->addDouble("infinite", infinite);
+        map->addInt("horizon_min_exponent", cMinExponent);
+        vv::Tuple* histogram = new vv::Tuple();
+        for (std::size_t count : horizons)
+            histogram->add(count);
+        map->add("horizons", histogram);
+        return map;
+    }
+
+    std::size_t inserts;      /**< added elements */
+    std::size_t updates;      /**< replaced elements */
+    std::size_t removes;      /**< removed elements, popAllAt included */
+    std::size_t cancels;      /**< cancelled elements */
+    std::size_t rearms;       /**< periodic elements moved to their next
+                                   period */
+    std::size_t rekeys;       /**< full rebuilds of the queue order (a
+                                   sort or heapify of every handle), done
+                                   by transformAll(); the other
+                                   operations only move single handles */
+    std::size_t compactions;  /**< tombstone compactions */
+    std::size_t peakSize;     /**< largest number of elements */
+    std::size_t tombstones;   /**< cancelled entries still queued */
+    std::size_t infinite;     /**< elements scheduled at infinity */
+    std::vector<std::size_t> horizons; /**< horizon histogram */
+    vd::Time    now;          /**< date of the last element removed at the
+                                   head */
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SORTED_QUEUE_HPP
+#define SORTED_QUEUE_HPP
+
+#include <vle/devs/Time.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace vd = vle::devs;
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class SortedQueue
+ *  @brief Sorted vector of scheduler handles
+ *
+ *  Handles are kept in decreasing key order, so the minimal handle sits at
+ *  the back of the vector and can be popped without shifting. Insertion and
+ *  key changes use a binary search and a single shift, no full sort.
+ */
+class SortedQueue
+{
+public:
+    typedef std::size_t Handle;
+    typedef vd::Time    Key;
+
+    /** @brief Insert a handle with the given key */
+    void push(Handle h, vd::Time key)
+    {
+        if (h >= mKeys.size())
+            mKeys.resize(h + 1);
+        mKeys[h] = key;
+        /* Equal keys are inserted in front of the existing ones, so they
+         * leave the queue in insertion order */
+        mNodes.insert(std::lower_bound(mNodes.begin(), mNodes.end(),
+                                       Node(key, h), Greater()),
+                      Node(key, h));
+    }
+
+    /** @brief Change the key of a queued handle */
+    void update(Handle h, vd::Time key)
+    {
+        erase(h);
+        push(h, key);
+    }
+
+    /** @brief Remove a queued handle */
+    void erase(Handle h)
+    {
+        mNodes.erase(find(h));
+    }
+
+    /** @brief Remove the minimal handle */
+    void pop()
+    {
+        if (mNodes.empty())
+            throw std::logic_error("SortedQueue is empty");
+        mNodes.pop_back();
+    }
+
+    inline Handle top() const
+    {
+        if (mNodes.empty())
+            throw std::logic_error("SortedQueue is empty");
+        return mNodes.back().handle;
+    }
+
+    inline vd::Time topKey() const
+    {return mNodes.back().key;}
+
+    inline bool empty() const
+    {return mNodes.empty();}
+
+    inline std::size_t size() const
+    {return mNodes.size();}
+
+    /** @brief Replace the key of every queued handle by key(handle) and
+     *         restore the ordering once */
+    template <typename F>
+    void rekey(F key)
+    {
+        for (Node& node : mNodes) {
+            node.key = key(node.handle);
+            mKeys[node.handle] = node.key;
+        }
+        std::stable_sort(mNodes.begin(), mNodes.end(), Greater());
+    }
+
+    inline void clear()
+    {
+        mNodes.clear();
+        mKeys.clear();
+    }
+
+    /** @brief Call f(handle) for every handle whose key is not above
+     *         limit */
+    template <typename F>
+    void forEachUntil(vd::Time limit, F f) const
+    {
+        typename std::vector<Node>::const_reverse_iterator it;
+        for (it = mNodes.rbegin(); it != mNodes.rend() && !(limit < it->key);
+             ++it)
+            f(it->handle);
+    }
+
+private:
+    struct Node
+    {
+        Node(vd::Time k, Handle h)
+        :key(k),handle(h)
+        {}
+
+        vd::Time key;
+        Handle   handle;
+    };
+
+    struct Greater
+    {
+        bool operator()(const Node& a, const Node& b) const
+        {return b.key < a.key;}
+    };
+
+    std::vector<Node>::iterator find(Handle h)
+    {
+        if (h >= mKeys.size())
+            throw std::logic_error("SortedQueue doesn't contain this handle");
+        std::pair<std::vector<Node>::iterator, std::vector<Node>::iterator>
+            range = std::equal_range(mNodes.begin(), mNodes.end(),
+                                     Node(mKeys[h], h), Greater());
+        for (std::vector<Node>::iterator it = range.first;
+             it != range.second; ++it) {
+            if (it->handle == h)
+                return it;
+        }
+        throw std::logic_error("SortedQueue doesn't contain this handle");
+    }
+
+private:
+    std::vector<Node>     mNodes; /**< (key, handle) in decreasing key order */
+    std::vector<vd::Time> mKeys;  /**< current key of each handle */
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
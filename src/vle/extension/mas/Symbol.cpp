@@ -0,0 +1,63 @@
+#include <vle/extension/mas/Symbol.hpp>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/* Entries are never moved nor freed, symbols point to them */
+struct Symbol::Table
+{
+    Table()
+    {
+        Entry empty = {0, std::string()};
+        entries.push_back(empty);
+        index.insert(std::make_pair(empty.str, &entries.back()));
+    }
+
+    std::mutex                                    mutex;
+    std::deque<Entry>                             entries;
+    std::unordered_map<std::string, const Entry*> index;
+};
+
+Symbol::Table& Symbol::table()
+{
+    static Table table;
+    return table;
+}
+
+Symbol::Symbol()
+:mEntry(&table().entries.front())
+{}
+
+const Symbol::Entry* Symbol::intern(const std::string& s)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    std::unordered_map<std::string, const Entry*>::const_iterator it =
+        t.index.find(s);
+    if (it != t.index.end())
+        return it->second;
+
+    Entry entry = {(Id)t.entries.size(), s};
+    t.entries.push_back(entry);
+    t.index.insert(std::make_pair(s, &t.entries.back()));
+    return &t.entries.back();
+}
+
+const void* Symbol::domain()
+{
+    return &table();
+}
+
+std::size_t Symbol::count()
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return t.entries.size();
+}
+
+}}}//namespace vle extension mas
@@ -0,0 +1,127 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems.
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class Symbol
+ *  @brief Interned string
+ *
+ *  Every distinct string gets a single entry in a process wide table, so
+ *  symbols are compared and hashed as integers. Interning a string takes
+ *  a lock; copying, comparing or reading a symbol doesn't.
+ *
+ *  Symbols are implicitly built from strings, so the functions taking a
+ *  symbol still accept strings.
+ */
+class Symbol
+{
+public:
+    typedef std::uint32_t Id;
+
+    /** @brief The empty symbol */
+    Symbol();
+
+    Symbol(const std::string& s)
+    :mEntry(intern(s))
+    {}
+
+    Symbol(const char* s)
+    :mEntry(intern(s))
+    {}
+
+    /** @brief Identifier of the symbol, in interning order from 0 for the
+     *         empty string */
+    inline Id id() const
+    {return mEntry->id;}
+
+    inline const std::string& str() const
+    {return mEntry->str;}
+
+    inline bool empty() const
+    {return mEntry->str.empty();}
+
+    /* Operator overload */
+    friend bool operator==(const Symbol& a, const Symbol& b)
+    {return a.mEntry == b.mEntry;}
+    friend bool operator!=(const Symbol& a, const Symbol& b)
+    {return a.mEntry != b.mEntry;}
+    friend bool operator< (const Symbol& a, const Symbol& b)
+    {return a.mEntry->id < b.mEntry->id;}
+
+    friend std::size_t hash_value(const Symbol& s)
+    {return s.mEntry->id;}
+
+    friend std::ostream& operator<<(std::ostream& out, const Symbol& s)
+    {return out << s.str();}
+
+    /** @brief Number of interned strings */
+    static std::size_t count();
+
+    /** @brief Identifies the symbol table in use. Modules linking their
+     *         own copy of this library have their own table, and their
+     *         symbols must be rebuilt from the strings */
+    static const void* domain();
+
+private:
+    struct Entry
+    {
+        Id          id;
+        std::string str;
+    };
+
+    struct Table;
+
+    static Table& table();
+    static const Entry* intern(const std::string& s);
+
+    const Entry* mEntry; /**< entry in the symbol table */
+};
+
+}
+}
+}// namespace vle extension mas
+
+namespace std {
+
+template <>
+struct hash<vle::extension::mas::Symbol>
+{
+    inline std::size_t operator()(const vle::extension::mas::Symbol& s) const
+    {return s.id();}
+};
+
+}
+
+#endif
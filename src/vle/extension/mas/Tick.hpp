@@ -0,0 +1,122 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TICK_HPP
+#define TICK_HPP
+
+#include <vle/devs/Time.hpp>
+
+#include <cmath>
+#include <limits>
+#include <cstdint>
+
+namespace vd = vle::devs;
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @brief Integer date, in ticks of a fixed resolution */
+typedef std::int64_t Tick;
+
+/** @class TickTime
+ *  @brief Conversion between simulation time and ticks
+ *
+ *  A tick lasts 1/Resolution time units. Dates are rounded to the nearest
+ *  tick, so dates closer than half a tick become equal. Infinite dates map
+ *  to the extreme ticks and back.
+ */
+template <std::int64_t Resolution>
+struct TickTime
+{
+    static const std::int64_t resolution = Resolution;
+
+    static inline Tick toTick(vd::Time t)
+    {
+        double ticks = std::floor(t * Resolution + 0.5);
+        if (!(ticks < (double)std::numeric_limits<Tick>::max()))
+            return std::numeric_limits<Tick>::max();
+        if (!(ticks > (double)std::numeric_limits<Tick>::min()))
+            return std::numeric_limits<Tick>::min();
+        return (Tick)ticks;
+    }
+
+    static inline vd::Time toTime(Tick k)
+    {
+        if (k == std::numeric_limits<Tick>::max())
+            return vd::infinity;
+        if (k == std::numeric_limits<Tick>::min())
+            return vd::negativeInfinity;
+        return (vd::Time)k / Resolution;
+    }
+};
+
+template <std::int64_t Resolution>
+const std::int64_t TickTime<Resolution>::resolution;
+
+/** @brief Order preserving mapping of ticks on unsigned integers */
+inline std::uint64_t tickBits(Tick k)
+{return (std::uint64_t)k ^ ((std::uint64_t)1 << 63);}
+
+/** @brief Number of bits needed to write x: 0 for 0, 64 for 2^63 */
+inline unsigned int bitWidth(std::uint64_t x)
+{
+    if (x == 0)
+        return 0;
+#ifdef __GNUC__
+    return 64 - __builtin_clzll(x);
+#else
+    unsigned int width = 0;
+    for (; x != 0; x >>= 1)
+        ++width;
+    return width;
+#endif
+}
+
+/** @brief Ten decimals, the precision the models used to truncate dates */
+typedef TickTime<10000000000LL> DefaultTickTime;
+
+/** @brief Date key of a scheduled element in ticks: T::getDate() rounded
+ *         to the TickTimeT resolution */
+template <typename T, typename TickTimeT = DefaultTickTime>
+struct TickDateOf
+{
+    typedef Tick type;
+
+    inline Tick operator()(const T& t) const
+    {return TickTimeT::toTick(t.getDate());}
+
+    static inline vd::Time toTime(Tick k)
+    {return TickTimeT::toTime(k);}
+
+    static inline Tick toKey(vd::Time t)
+    {return TickTimeT::toTick(t);}
+
+    static inline void setDate(T& t, Tick k)
+    {t.setDate(TickTimeT::toTime(k));}
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TIMING_WHEEL_QUEUE_HPP
+#define TIMING_WHEEL_QUEUE_HPP
+
+#include <vle/extension/mas/Tick.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @class TimingWheelQueue
+ *  @brief Hierarchical timing wheel of scheduler handles, on Tick keys
+ *
+ *  Each level is a wheel of 64 slots covering 6 bits of the keys. A key
+ *  lives at the level of the highest digit in which it differs from the
+ *  current time (the last removed minimum), in the slot of that digit:
+ *  level 0 slots hold exact ticks. Slots are intrusive lists and each level
+ *  keeps a bitmap of its busy slots, so push, update and erase are O(1)
+ *  without allocation: re-arming a periodic handle only moves it between
+ *  two lists. When the minimum leaves, its slot is cascaded to the lower
+ *  levels.
+ *
+ *  Like RadixHeapQueue, the queue is meant for keys not going back in
+ *  time; a key below the current time costs a rebuild.
+ */
+class TimingWheelQueue
+{
+public:
+    typedef std::size_t Handle;
+    typedef Tick        Key;
+
+    TimingWheelQueue()
+    :mNow(0), mSize(0), mTop(npos)
+    {}
+
+    /** @brief Insert a handle with the given key */
+    void push(Handle h, Tick key)
+    {
+        if (h >= mEntries.size())
+            mEntries.resize(h + 1);
+        if (mEntries[h].queued)
+            throw std::logic_error("TimingWheelQueue already contains "
+                                   "this handle");
+        if (key < mNow)
+            rebase(key);
+        insert(h, key);
+        if (mTop != npos && key < mEntries[mTop].key)
+            mTop = h;
+    }
+
+    /** @brief Change the key of a queued handle */
+    void update(Handle h, Tick key)
+    {
+        check(h);
+        unlink(h);
+        if (key < mNow)
+            rebase(key);
+        link(h, key);
+        if (mTop == h)
+            mTop = npos;
+        else if (mTop != npos && key < mEntries[mTop].key)
+            mTop = h;
+    }
+
+    /** @brief Remove a queued handle */
+    void erase(Handle h)
+    {
+        check(h);
+        bool minimum = (h == top());
+        unlink(h);
+        mEntries[h].queued = false;
+        --mSize;
+        mTop = npos;
+        if (minimum)
+            advance();
+    }
+
+    /** @brief Remove the minimal handle */
+    void pop()
+    {
+        erase(top());
+    }
+
+    inline Handle top() const
+    {
+        if (empty())
+            throw std::logic_error("TimingWheelQueue is empty");
+        if (mTop == npos)
+            mTop = findTop();
+        return mTop;
+    }
+
+    inline Tick topKey() const
+    {return mEntries[top()].key;}
+
+    inline bool empty() const
+    {return mSize == 0;}
+
+    inline std::size_t size() const
+    {return mSize;}
+
+    /** @brief Replace the key of every queued handle by key(handle) and
+     *         restore the ordering once */
+    template <typename F>
+    void rekey(F key)
+    {
+        std::vector<Handle> handles = unlinkAll();
+        if (!handles.empty()) {
+            mNow = std::numeric_limits<Tick>::max();
+            for (Handle h : handles) {
+                mEntries[h].key = key(h);
+                if (mEntries[h].key < mNow)
+                    mNow = mEntries[h].key;
+            }
+        }
+        for (Handle h : handles)
+            link(h, mEntries[h].key);
+        mTop = npos;
+    }
+
+    inline void clear()
+    {
+        mLevels.clear();
+        mEntries.clear();
+        mNow = 0;
+        mSize = 0;
+        mTop = npos;
+    }
+
+    /** @brief Call f(handle) for every handle whose key is not above
+     *         limit */
+    template <typename F>
+    void forEachUntil(Tick limit, F f) const
+    {
+        /* Slots hold increasing key ranges, level by level: stop at the
+         * first one above limit */
+        for (const Level& level : mLevels) {
+            for (std::uint64_t busy = level.busy; busy != 0;
+                 busy &= busy - 1) {
+                bool below = false;
+                for (Handle h = level.slots[bitWidth(busy & -busy) - 1];
+                     h != npos; h = mEntries[h].next) {
+                    if (!(limit < mEntries[h].key)) {
+                        f(h);
+                        below = true;
+                    }
+                }
+                if (!below)
+                    return;
+            }
+        }
+    }
+
+private:
+    static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static const unsigned int cBits = 6;
+    static const unsigned int cSlots = 1 << cBits;
+
+    struct Entry
+    {
+        Entry()
+        :key(0),previous(npos),next(npos),level(0),slot(0),queued(false)
+        {}
+
+        Tick          key;
+        Handle        previous; /**< previous handle in the slot */
+        Handle        next;     /**< next handle in the slot */
+        unsigned char level;
+        unsigned char slot;
+        bool          queued;
+    };
+
+    struct Level
+    {
+        Level()
+        :busy(0)
+        {
+            for (Handle& head : slots)
+                head = npos;
+        }
+
+        Handle        slots[cSlots]; /**< first handle of each slot */
+        std::uint64_t busy;          /**< bitmap of the non empty slots */
+    };
+
+    inline void check(Handle h) const
+    {
+        if (h >= mEntries.size() || !mEntries[h].queued)
+            throw std::logic_error("TimingWheelQueue doesn't contain "
+                                   "this handle");
+    }
+
+    void insert(Handle h, Tick key)
+    {
+        mEntries[h].queued = true;
+        link(h, key);
+        ++mSize;
+    }
+
+    void link(Handle h, Tick key)
+    {
+        Entry& e = mEntries[h];
+        unsigned int width = bitWidth(tickBits(key) ^ tickBits(mNow));
+        unsigned int level = width == 0 ? 0 : (width - 1) / cBits;
+        if (level >= mLevels.size())
+            mLevels.resize(level + 1);
+        e.key = key;
+        e.level = level;
+        e.slot = (tickBits(key) >> (level * cBits)) & (cSlots - 1);
+
+        Handle& head = mLevels[level].slots[e.slot];
+        e.previous = npos;
+        e.next = head;
+        if (head != npos)
+            mEntries[head].previous = h;
+        head = h;
+        mLevels[level].busy |= (std::uint64_t)1 << e.slot;
+    }
+
+    void unlink(Handle h)
+    {
+        Entry& e = mEntries[h];
+        Level& level = mLevels[e.level];
+        if (e.previous != npos)
+            mEntries[e.previous].next = e.next;
+        else
+            level.slots[e.slot] = e.next;
+        if (e.next != npos)
+            mEntries[e.next].previous = e.previous;
+        if (level.slots[e.slot] == npos)
+            level.busy &= ~((std::uint64_t)1 << e.slot);
+    }
+
+    /* First non empty slot: lowest busy slot of the lowest busy level */
+    inline bool firstSlot(unsigned int& level, unsigned int& slot) const
+    {
+        for (level = 0; level < mLevels.size(); ++level) {
+            std::uint64_t busy = mLevels[level].busy;
+            if (busy != 0) {
+                slot = bitWidth(busy & -busy) - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Handle findTop() const
+    {
+        unsigned int level, slot;
+        firstSlot(level, slot);
+        Handle best = mLevels[level].slots[slot];
+        if (level > 0) {
+            for (Handle h = best; h != npos; h = mEntries[h].next) {
+                if (mEntries[h].key < mEntries[best].key)
+                    best = h;
+            }
+        }
+        return best;
+    }
+
+    /* Move the current time to the new minimum and cascade its slot to
+     * the lower levels */
+    void advance()
+    {
+        unsigned int level, slot;
+        if (!firstSlot(level, slot) || level == 0)
+            return;
+        mTop = findTop();
+        mNow = mEntries[mTop].key;
+        Handle h = mLevels[level].slots[slot];
+        mLevels[level].slots[slot] = npos;
+        mLevels[level].busy &= ~((std::uint64_t)1 << slot);
+        while (h != npos) {
+            Handle next = mEntries[h].next;
+            link(h, mEntries[h].key);
+            h = next;
+        }
+    }
+
+    std::vector<Handle> unlinkAll()
+    {
+        std::vector<Handle> handles;
+        handles.reserve(mSize);
+        for (Level& level : mLevels) {
+            for (Handle& head : level.slots) {
+                for (Handle h = head; h != npos; h = mEntries[h].next)
+                    handles.push_back(h);
+                head = npos;
+            }
+            level.busy = 0;
+        }
+        return handles;
+    }
+
+    /* A key below the current time: rebuild the wheels around it */
+    void rebase(Tick key)
+    {
+        std::vector<Handle> handles = unlinkAll();
+        mNow = key;
+        for (Handle h : handles)
+            link(h, mEntries[h].key);
+    }
+
+private:
+    std::vector<Level> mLevels;  /**< wheels, from the finest */
+    std::vector<Entry> mEntries; /**< state of each handle */
+    Tick               mNow;     /**< current time, last removed minimum */
+    std::size_t        mSize;    /**< queued handles count */
+    mutable Handle     mTop;     /**< cached minimum */
+};
+
+}
+}
+}// namespace vle extension mas
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems.
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef TYPED_EFFECT_HPP
+#define TYPED_EFFECT_HPP
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <vle/devs/Time.hpp>
+#include <vle/value/Value.hpp>
+#include <vle/extension/mas/PropertyContainer.hpp>
+#include <vle/extension/mas/Symbol.hpp>
+
+#include <cstdint>
+#include <tuple>
+#include <stdexcept>
+#include <type_traits>
+
+namespace vd = vle::devs;
+namespace vv = vle::value;
+
+/** @brief Declare a field of an EffectSchema: a tag type named Name
+ *         holding a value of type Type */
+#define MAS_EFFECT_FIELD(Name, Type)                                         \
+    struct Name                                                              \
+    {                                                                        \
+        typedef Type type;                                                   \
+        static const char* name() {return #Name;}                            \
+    }
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+template <typename T>
+struct IdentityOf;
+
+/** @brief Position of Field in Fields, a compilation error if it is not
+ *         one of them */
+template <typename Field, typename... Fields>
+struct FieldIndex;
+
+template <typename Field, typename... Rest>
+struct FieldIndex<Field, Field, Rest...>
+    : std::integral_constant<std::size_t, 0>
+{};
+
+template <typename Field, typename Other, typename... Rest>
+struct FieldIndex<Field, Other, Rest...>
+    : std::integral_constant<std::size_t,
+                             1 + FieldIndex<Field, Rest...>::value>
+{};
+
+/** @brief Check if every type can be held by a Property: double, int,
+ *         std::int64_t, bool, Symbol or std::string */
+template <typename... Types>
+struct PropertyTypes : std::true_type
+{};
+
+template <typename Type, typename... Rest>
+struct PropertyTypes<Type, Rest...>
+    : std::integral_constant<bool,
+                             (std::is_same<Type, double>::value
+                              || std::is_same<Type, int>::value
+                              || std::is_same<Type, std::int64_t>::value
+                              || std::is_same<Type, bool>::value
+                              || std::is_same<Type, Symbol>::value
+                              || std::is_same<Type, std::string>::value)
+                             && PropertyTypes<Rest...>::value>
+{};
+
+/** @class EffectSchema
+ *  @brief Compile time list of the fields of a TypedEffect
+ *
+ *  Fields are declared with MAS_EFFECT_FIELD; their values are stored
+ *  inline in a tuple. Field names are only used by the dynamic access,
+ *  which reads each field through a Property.
+ */
+template <typename... Fields>
+struct EffectSchema
+{
+    static_assert(PropertyTypes<typename Fields::type...>::value,
+                  "effect fields must be double, int, std::int64_t, bool, "
+                  "Symbol or std::string");
+
+    typedef std::tuple<typename Fields::type...> Values;
+
+    static const std::size_t size = sizeof...(Fields);
+
+    template <typename Field>
+    struct index : FieldIndex<Field, Fields...>
+    {};
+
+    /** @brief Check if a field is called name */
+    template <std::size_t I = 0>
+    static typename std::enable_if<(I == size), bool>::type
+    contains(const std::string&)
+    {return false;}
+
+    template <std::size_t I = 0>
+    static typename std::enable_if<(I < size), bool>::type
+    contains(const std::string& name)
+    {return name == FieldAt<I>::name() || contains<I + 1>(name);}
+
+    /** @brief New value of the field called name, null if there is none */
+    template <std::size_t I = 0>
+    static typename std::enable_if<(I == size), vv::Value*>::type
+    valueOf(const Values&, const std::string&)
+    {return 0;}
+
+    template <std::size_t I = 0>
+    static typename std::enable_if<(I < size), vv::Value*>::type
+    valueOf(const Values& values, const std::string& name)
+    {
+        if (name == FieldAt<I>::name())
+            return toProperty(std::get<I>(values)).toValue();
+        return valueOf<I + 1>(values, name);
+    }
+
+    /** @brief Add every field to a property container */
+    template <std::size_t I = 0>
+    static typename std::enable_if<(I == size)>::type
+    fill(const Values&, PropertyContainer&)
+    {}
+
+    template <std::size_t I = 0>
+    static typename std::enable_if<(I < size)>::type
+    fill(const Values& values, PropertyContainer& properties)
+    {
+        properties.add(FieldAt<I>::name(), toProperty(std::get<I>(values)));
+        fill<I + 1>(values, properties);
+    }
+
+private:
+    template <std::size_t I>
+    struct FieldAt : std::tuple_element<I, std::tuple<Fields...> >::type
+    {};
+
+    /* Property of a field, shared by valueOf() and fill() */
+    static inline Property toProperty(double v)
+    {return Property(v);}
+
+    static inline Property toProperty(int v)
+    {return Property((std::int64_t)v);}
+
+    static inline Property toProperty(std::int64_t v)
+    {return Property(v);}
+
+    static inline Property toProperty(bool v)
+    {return Property(v);}
+
+    static inline Property toProperty(const Symbol& v)
+    {return Property(v);}
+
+    static inline Property toProperty(const std::string& v)
+    {return Property(Symbol(v));}
+};
+
+/** @class TypedEffect
+ *  @brief Effect whose fields are declared at compile time by a Schema
+ *
+ *  Field values live inside the effect, so building, copying or reading
+ *  an effect doesn't allocate values nor hash names:
+ *  @code
+ *  MAS_EFFECT_FIELD(Speed, double);
+ *  typedef TypedEffect<EffectSchema<Speed> > MoveEffect;
+ *  MoveEffect e(t, "move", origin);
+ *  e.set<Speed>(2.0);
+ *  double speed = e.get<Speed>();
+ *  @endcode
+ *  Effects are also readable by name through the PropertyContainer
+ *  interface (exists, get), which builds the values on demand.
+ *  @see Effect
+ */
+template <typename Schema>
+class TypedEffect
+{
+public:
+    /**  Function prototype which will be use to apply effect */
+    typedef boost::function<void (const TypedEffect&)> EffectFunction;
+    typedef typename Schema::Values Values;
+
+public:
+    TypedEffect(const vd::Time& t,const Symbol& name,const Symbol& origin)
+    :mDate(t),mName(name),mOrigin(origin),mFields()
+    {}
+
+    inline vd::Time getDate() const
+    {return mDate;}
+
+    inline void setDate(vd::Time d)
+    {mDate = d;}
+
+    inline const std::string& getName() const
+    {return mName.str();}
+
+    inline const std::string& getOrigin() const
+    {return mOrigin.str();}
+
+    inline const Symbol& getNameSymbol() const
+    {return mName;}
+
+    inline const Symbol& getOriginSymbol() const
+    {return mOrigin;}
+
+    /* Typed access */
+    template <typename Field>
+    inline const typename Field::type& get() const
+    {return std::get<Schema::template index<Field>::value>(mFields);}
+
+    template <typename Field>
+    inline void set(const typename Field::type& v)
+    {std::get<Schema::template index<Field>::value>(mFields) = v;}
+
+    /* Dynamic access, as a PropertyContainer */
+    inline bool exists(const Symbol& title) const
+    {return Schema::contains(title.str());}
+
+    PropertyContainer::value_ptr get(const Symbol& p) const
+    {
+        vv::Value* value = Schema::valueOf(mFields, p.str());
+        if (!value)
+            throw std::logic_error("Runtime error(TypedEffect): property "
+                                   "operation failed => key=" + p.str());
+        return PropertyContainer::value_ptr(value);
+    }
+
+    /** @brief Copy of the fields in a PropertyContainer */
+    PropertyContainer properties() const
+    {
+        PropertyContainer properties;
+        Schema::fill(mFields, properties);
+        return properties;
+    }
+
+    /* Operator overload */
+    friend bool operator==(const TypedEffect& a,const TypedEffect& b)
+    {
+        return (a.mName == b.mName)
+               &&(a.mOrigin == b.mOrigin);
+    }
+    friend bool operator!=(const TypedEffect& a, const TypedEffect& b)
+    {return !operator==(a,b);}
+    friend bool operator< (const TypedEffect& a,const TypedEffect& b)
+    {return a.mDate < b.mDate;}
+private:
+    TypedEffect();
+private:
+    vd::Time     mDate; /**< Date when effect must be applied */
+    Symbol       mName; /**< Name of effect */
+    Symbol       mOrigin; /**< Origin(model name) of effect */
+    Values       mFields; /**< Field values, in schema order */
+};
+
+/** @brief Typed effects are identified by their name and their origin */
+template <typename Schema>
+struct IdentityOf<TypedEffect<Schema> >
+{
+    typedef std::pair<Symbol, Symbol> type;
+    typedef boost::hash<type> hash;
+
+    inline type operator()(const TypedEffect<Schema>& e) const
+    {return type(e.getNameSymbol(), e.getOriginSymbol());}
+};
+
+}}} //namespace vle extension mas
+#endif
@@ -0,0 +1,133 @@
+/*
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems.
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2013 INRA http://www.inra.fr
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef TYPED_MESSAGE_HPP
+#define TYPED_MESSAGE_HPP
+#include <vle/value/Tuple.hpp>
+#include <vle/extension/mas/Message.hpp>
+#include <vle/extension/mas/Symbol.hpp>
+
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/seq/for_each_i.hpp>
+#include <boost/preprocessor/variadic/size.hpp>
+#include <boost/preprocessor/variadic/to_seq.hpp>
+
+#include <stdexcept>
+
+namespace vv = vle::value;
+
+/** @brief Declare a message type Name with the given double fields, e.g.
+ *         MAS_MESSAGE(BirdPosition, x, y, dx, dy, radius)
+ *
+ *  The fields are stored inline in the message, and travel in a single
+ *  tuple attribute named after the type when the message is copied; see
+ *  encodeMessage and decodeMessage. */
+#define MAS_MESSAGE(Name, ...)                                               \
+    struct Name                                                              \
+    {                                                                        \
+        BOOST_PP_SEQ_FOR_EACH(MAS_MESSAGE_FIELD, _,                          \
+                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))         \
+                                                                             \
+        static const std::size_t cSize =                                     \
+            BOOST_PP_VARIADIC_SIZE(__VA_ARGS__);                             \
+                                                                             \
+        static std::size_t size()                                            \
+        {return cSize;}                                                      \
+                                                                             \
+        static const ::vle::extension::mas::Symbol& key()                   \
+        {                                                                    \
+            static const ::vle::extension::mas::Symbol k(#Name);             \
+            return k;                                                        \
+        }                                                                    \
+                                                                             \
+        void encode(double* values) const                                    \
+        {                                                                    \
+            BOOST_PP_SEQ_FOR_EACH_I(MAS_MESSAGE_ENCODE, values,              \
+                                    BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))   \
+        }                                                                    \
+                                                                             \
+        void decode(const double* values)                                    \
+        {                                                                    \
+            BOOST_PP_SEQ_FOR_EACH_I(MAS_MESSAGE_DECODE, values,              \
+                                    BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))   \
+        }                                                                    \
+    }
+
+#define MAS_MESSAGE_FIELD(r, data, field) double field;
+#define MAS_MESSAGE_ENCODE(r, values, i, field) values[i] = field;
+#define MAS_MESSAGE_DECODE(r, values, i, field) field = values[i];
+
+namespace vle {
+namespace extension {
+namespace mas {
+
+/** @brief Fields of the T carried by m, null if m has none
+ *
+ *  They are inline in the message, or in a tuple attribute when m went
+ *  through the DEVS attributes. */
+template <typename T>
+const double* payloadOf(const Message& m)
+{
+    if (const double* values = m.getPayload(T::key(), T::size()))
+        return values;
+    const Property* p = m.find(T::key());
+    if (!p || p->type() != Property::VALUE || !p->getValue().isTuple())
+        return nullptr;
+    const vv::Tuple& values = p->getValue().toTuple();
+    return values.size() == T::size() ? values.value().data() : nullptr;
+}
+
+/** @brief Store the fields of payload inline in m, keyed by the message
+ *         type */
+template <typename T>
+void encodeMessage(const T& payload, Message& m)
+{
+    static_assert(T::cSize <= Message::cPayloadCapacity,
+                  "too many fields for an inline payload");
+    double values[T::cSize];
+    payload.encode(values);
+    m.setPayload(T::key(), values, T::cSize);
+}
+
+/** @brief Check if m carries a T */
+template <typename T>
+inline bool carries(const Message& m)
+{return payloadOf<T>(m) != nullptr;}
+
+/** @brief The T carried by m, throws if it carries none */
+template <typename T>
+T decodeMessage(const Message& m)
+{
+    const double* values = payloadOf<T>(m);
+    if (!values)
+        throw std::logic_error("Runtime error(Message): no " + T::key().str()
+                               + " in message " + m.getSubject());
+    T payload;
+    payload.decode(values);
+    return payload;
+}
+
+}}} //namespace vle extension mas
+#endif
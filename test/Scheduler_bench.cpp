@@ -0,0 +1,335 @@
+/*
+ * Scheduler benchmark: replays add/update/remove/next traces against every
+ * Scheduler backend and reports ns/op, allocations/op and peak memory.
+ *
+ *   scheduler-bench              synthetic Bird and BallG traces,
+ *                                10 to 10^6 scheduled effects
+ *   scheduler-bench trace.txt    replay a recorded trace
+ *
+ * A trace file holds one operation per line:
+ *   a <id> <date>   add the effect of agent id at date
+ *   u <id> <date>   update the date of the effect of agent id
+ *   r <id>          cancel the effect of agent id
+ *   n               pop all the effects of the next date
+ */
+#include <vle/extension/mas/Scheduler.hpp>
+#include <vle/extension/mas/Effect.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace vemas = vle::extension::mas;
+
+/******************************* Allocations *******************************/
+namespace {
+
+std::size_t gAllocations = 0;
+std::size_t gLiveBytes = 0;
+std::size_t gPeakBytes = 0;
+
+/* Every block starts with its size, so the live bytes can be followed */
+const std::size_t cHeader = 16;
+
+void* allocate(std::size_t size)
+{
+    void* block = std::malloc(size + cHeader);
+    if (!block)
+        throw std::bad_alloc();
+    *static_cast<std::size_t*>(block) = size;
+    ++gAllocations;
+    gLiveBytes += size;
+    if (gLiveBytes > gPeakBytes)
+        gPeakBytes = gLiveBytes;
+    return static_cast<char*>(block) + cHeader;
+}
+
+void deallocate(void* p)
+{
+    if (!p)
+        return;
+    void* block = static_cast<char*>(p) - cHeader;
+    gLiveBytes -= *static_cast<std::size_t*>(block);
+    std::free(block);
+}
+
+}
+
+void* operator new(std::size_t size) {return allocate(size);}
+void* operator new[](std::size_t size) {return allocate(size);}
+void operator delete(void* p) noexcept {deallocate(p);}
+void operator delete[](void* p) noexcept {deallocate(p);}
+
+/********************************* Traces **********************************/
+struct Op
+{
+    enum Type {ADD, UPDATE, REMOVE, NEXT};
+
+    Type        type;
+    std::size_t id;
+    double      date;
+};
+
+struct Trace
+{
+    std::string     name;
+    std::size_t     agents;  /**< number of distinct ids */
+    std::size_t     prefill; /**< leading operations, not measured */
+    std::vector<Op> ops;
+};
+
+/* Operation mix and horizon distribution of a model */
+struct Model
+{
+    const char* name;
+    int         add, update, remove, next; /**< weights */
+    double      quantum;   /**< date resolution */
+    double      infinite;  /**< proportion of effects at infinity */
+    bool        uniform;   /**< uniform or exponential horizons */
+    double      horizon;   /**< bound or mean of the horizons */
+};
+
+/* Bird: many neighbourhood effects moved around, some never due */
+const Model cBird = {"bird", 15, 45, 15, 25, 1e-9, 0.05, false, 1.0};
+/* BallG: collisions at quantized dates, so ties are frequent */
+const Model cBall = {"ball", 25, 25, 25, 25, 1e-3, 0.0, true, 10.0};
+
+/* Generate a trace keeping about size effects scheduled. A reference set
+ * gives the effects popped by NEXT, so the trace is valid for every
+ * backend. */
+Trace generate(const Model& model, std::size_t size, std::size_t count,
+               unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::exponential_distribution<double> exponential(1.0 / model.horizon);
+    std::discrete_distribution<int> mix({(double)model.add,
+                                         (double)model.update,
+                                         (double)model.remove,
+                                         (double)model.next});
+
+    Trace trace;
+    trace.name = model.name;
+    trace.agents = 2 * size;
+    std::vector<double> dates(trace.agents, -1);
+    std::vector<std::size_t> live, free;
+    std::vector<std::size_t> position(trace.agents);
+    std::set<std::pair<double, std::size_t> > queue;
+    double now = 0;
+
+    for (std::size_t id = trace.agents; id-- > 0;)
+        free.push_back(id);
+
+    auto draw = [&]() -> double {
+        if (uniform(gen) < model.infinite)
+            return vd::infinity;
+        double h = model.uniform ? model.horizon * uniform(gen)
+                                 : exponential(gen);
+        double date = now + h;
+        /* Ticks must not merge dates the reference keeps apart */
+        return std::ceil(date / model.quantum) * model.quantum;
+    };
+    auto add = [&](std::size_t id, double date) {
+        dates[id] = date;
+        position[id] = live.size();
+        live.push_back(id);
+        queue.insert(std::make_pair(date, id));
+    };
+    auto drop = [&](std::size_t id) {
+        queue.erase(std::make_pair(dates[id], id));
+        live[position[id]] = live.back();
+        position[live.back()] = position[id];
+        live.pop_back();
+        free.push_back(id);
+        dates[id] = -1;
+    };
+
+    for (std::size_t i = 0; i < size; ++i) {
+        Op op = {Op::ADD, free.back(), draw()};
+        free.pop_back();
+        add(op.id, op.date);
+        trace.ops.push_back(op);
+    }
+    trace.prefill = trace.ops.size();
+
+    while (trace.ops.size() < trace.prefill + count) {
+        Op op = {(Op::Type)mix(gen), 0, 0.0};
+        if (op.type == Op::ADD && live.size() >= size)
+            op.type = Op::UPDATE;
+        if ((op.type == Op::REMOVE || op.type == Op::NEXT)
+            && live.size() < size)
+            op.type = Op::ADD;
+        if (op.type == Op::NEXT && queue.begin()->first == vd::infinity)
+            op.type = Op::UPDATE;
+
+        switch (op.type) {
+        case Op::ADD:
+            op.id = free.back();
+            free.pop_back();
+            op.date = draw();
+            add(op.id, op.date);
+            break;
+        case Op::UPDATE:
+            op.id = live[gen() % live.size()];
+            op.date = draw();
+            queue.erase(std::make_pair(dates[op.id], op.id));
+            dates[op.id] = op.date;
+            queue.insert(std::make_pair(op.date, op.id));
+            break;
+        case Op::REMOVE:
+            op.id = live[gen() % live.size()];
+            drop(op.id);
+            break;
+        case Op::NEXT:
+            now = queue.begin()->first;
+            while (!queue.empty() && queue.begin()->first == now)
+                drop(queue.begin()->second);
+            break;
+        }
+        trace.ops.push_back(op);
+    }
+    return trace;
+}
+
+/* Read a trace file, see the header of this file */
+Trace load(const char* path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error(std::string("can't read ") + path);
+
+    Trace trace;
+    trace.name = path;
+    trace.agents = 0;
+    trace.prefill = 0;
+    char type;
+    while (in >> type) {
+        Op op = {Op::NEXT, 0, 0.0};
+        switch (type) {
+        case 'a': op.type = Op::ADD; in >> op.id >> op.date; break;
+        case 'u': op.type = Op::UPDATE; in >> op.id >> op.date; break;
+        case 'r': op.type = Op::REMOVE; in >> op.id; break;
+        case 'n': break;
+        default:
+            throw std::runtime_error(std::string("bad operation in ") + path);
+        }
+        if (op.id + 1 > trace.agents)
+            trace.agents = op.id + 1;
+        trace.ops.push_back(op);
+    }
+    return trace;
+}
+
+/********************************** Replay *********************************/
+struct Result
+{
+    double      nsPerOp;
+    double      allocsPerOp;
+    std::size_t peakBytes;
+};
+
+template <typename SchedulerT>
+Result replay(const Trace& trace)
+{
+    std::vector<vemas::Effect> effects;
+    effects.reserve(trace.agents);
+    for (std::size_t id = 0; id < trace.agents; ++id)
+        effects.push_back(vemas::Effect(0.0, "collision",
+                                        "agent" + std::to_string(id)));
+
+    gPeakBytes = gLiveBytes;
+    std::size_t base = gLiveBytes;
+    SchedulerT s;
+    std::size_t allocations = 0;
+    std::chrono::steady_clock::time_point start;
+
+    for (std::size_t i = 0; i < trace.ops.size(); ++i) {
+        if (i == trace.prefill) {
+            allocations = gAllocations;
+            start = std::chrono::steady_clock::now();
+        }
+        const Op& op = trace.ops[i];
+        vemas::Effect& effect = effects[op.id];
+        switch (op.type) {
+        case Op::ADD:
+            effect.setDate(op.date);
+            s.addEffect(effect);
+            break;
+        case Op::UPDATE:
+            effect.setDate(op.date);
+            s.update(effect);
+            break;
+        case Op::REMOVE:
+            s.cancel(effect);
+            break;
+        case Op::NEXT:
+            s.popAllAt(s.nextKey());
+            break;
+        }
+    }
+
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    double ops = trace.ops.size() - trace.prefill;
+    Result result;
+    result.nsPerOp = std::chrono::duration<double, std::nano>(
+                         end - start).count() / ops;
+    result.allocsPerOp = (gAllocations - allocations) / ops;
+    result.peakBytes = gPeakBytes - base;
+    return result;
+}
+
+template <typename SchedulerT>
+void run(const char* backend, const Trace& trace, std::size_t size)
+{
+    Result r = replay<SchedulerT>(trace);
+    std::printf("%-8s %-14s %8zu %10.1f %10.2f %12.1f\n",
+                trace.name.c_str(), backend, size, r.nsPerOp, r.allocsPerOp,
+                r.peakBytes / 1024.0);
+}
+
+void runAll(const Trace& trace, std::size_t size)
+{
+    using vemas::Effect;
+    run<vemas::Scheduler<Effect> >("sorted", trace, size);
+    run<vemas::Scheduler<Effect, vemas::HeapQueue<2> > >("heap<2>", trace,
+                                                         size);
+    run<vemas::Scheduler<Effect, vemas::HeapQueue<4> > >("heap<4>", trace,
+                                                         size);
+    run<vemas::Scheduler<Effect, vemas::CalendarQueue> >("calendar", trace,
+                                                         size);
+    run<vemas::Scheduler<Effect, vemas::RadixHeapQueue,
+                         vemas::TickDateOf<Effect> > >("radix/ticks", trace,
+                                                       size);
+    run<vemas::Scheduler<Effect, vemas::TimingWheelQueue,
+                         vemas::TickDateOf<Effect> > >("wheel/ticks", trace,
+                                                       size);
+}
+
+int main(int argc, char** argv)
+{
+    std::printf("%-8s %-14s %8s %10s %10s %12s\n", "trace", "backend",
+                "size", "ns/op", "allocs/op", "peak KiB");
+
+    if (argc > 1) {
+        Trace trace = load(argv[1]);
+        runAll(trace, trace.agents);
+        return 0;
+    }
+
+    for (std::size_t size = 10; size <= 1000000; size *= 10) {
+        /* Fewer operations on large queues: the sorted vector is O(n) */
+        std::size_t count = size <= 10000 ? 200000 : 2000000000 / size;
+        runAll(generate(cBird, size, count, 1), size);
+        runAll(generate(cBall, size, count, 2), size);
+    }
+    return 0;
+}
@@ -6,8 +6,21 @@
 #include <boost/test/auto_unit_test.hpp>
 
 #include <vle/extension/mas/Scheduler.hpp>
+#include <vle/extension/mas/Effect.hpp>
+#include <vle/extension/mas/TypedEffect.hpp>
+#include <vle/extension/mas/Arena.hpp>
+#include <vle/extension/mas/EffectTable.hpp>
+#include <vle/extension/mas/TypedMessage.hpp>
+#include <vle/extension/mas/MessageValue.hpp>
+
+#include <random>
 
 namespace vemas = vle::extension::mas;
+
+MAS_EFFECT_FIELD(Wall, bool);
+MAS_EFFECT_FIELD(Speed, double);
+MAS_EFFECT_FIELD(Count, int);
+
 struct A {
     A() {
         BOOST_TEST_MESSAGE("setup fixture");
@@ -65,3 +78,988 @@ BOOST_AUTO_TEST_CASE(empty_heap_test)
     }
 }
 BOOST_AUTO_TEST_SUITE_END();
+
+struct B {
+    vemas::Scheduler<int, vemas::HeapQueue<4> > s;
+};
+
+BOOST_FIXTURE_TEST_SUITE(dary_heap_test, B)
+BOOST_AUTO_TEST_CASE(heap_sort_test)
+{
+    const int values[] = {999, 1, 66, 99, 33, 4, 9, 12, 7, 500, 2};
+    for (int v : values)
+        s.addEffect(v);
+
+    std::vector<int> sorted(values, values + 11);
+    std::sort(sorted.begin(), sorted.end());
+    for (int v : sorted) {
+        BOOST_REQUIRE_EQUAL(s.nextEffect(), v);
+        s.removeNextEffect();
+    }
+    BOOST_REQUIRE(s.empty());
+}
+
+BOOST_AUTO_TEST_CASE(handle_test)
+{
+    vemas::Scheduler<int, vemas::HeapQueue<4> >::Handle h5 = s.addEffect(5);
+    vemas::Scheduler<int, vemas::HeapQueue<4> >::Handle h8 = s.addEffect(8);
+    s.addEffect(3);
+
+    s.update(h8, 1);
+    BOOST_REQUIRE_EQUAL(s.nextEffect(), 1);
+    BOOST_REQUIRE_EQUAL(s.get(h5), 5);
+
+    s.remove(h8);
+    BOOST_REQUIRE(!s.contains(h8));
+    BOOST_REQUIRE_EQUAL(s.size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect(), 3);
+
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextEffect(), 5);
+    BOOST_REQUIRE_EQUAL(s.get(h5), 5);
+}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_CASE(effect_identity_test)
+{
+    vemas::Scheduler<vemas::Effect> s;
+
+    s.addEffect(vemas::Effect(3.0, "collision", "ball1"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball2"));
+    s.addEffect(vemas::Effect(4.0, "enterAgain", "ball1"));
+
+    BOOST_REQUIRE(s.exists(vemas::Effect(0.0, "collision", "ball1")));
+    BOOST_REQUIRE(!s.exists(vemas::Effect(0.0, "collision", "ball3")));
+
+    s.update(vemas::Effect(1.0, "collision", "ball1"));
+    BOOST_REQUIRE_EQUAL(s.size(), 3u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball1");
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getDate(), 1.0);
+
+    try {
+        s.addEffect(vemas::Effect(5.0, "collision", "ball2"));
+        BOOST_FAIL("Exception must be raised..");
+    } catch (const std::logic_error& e) {
+        BOOST_TEST_MESSAGE("Exception successfully catched : ");
+    }
+}
+
+/* Pops every element of a scheduler fed with the same random operations as
+ * a reference scheduler and compares their dates */
+template <typename Queue>
+void compareWithSortedQueue(double horizon)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dates(0.0, horizon);
+    vemas::Scheduler<double> reference;
+    vemas::Scheduler<double, Queue> s;
+    std::vector<double> values;
+
+    for (int i = 0; i < 2000; ++i) {
+        double d = dates(gen);
+        values.push_back(d);
+        reference.addEffect(d);
+        s.addEffect(d);
+    }
+    for (int i = 0; i < 500; ++i) {
+        double d = dates(gen) + horizon;
+        s.update(s.handle(values[i]), d);
+        reference.update(reference.handle(values[i]), d);
+    }
+    for (int i = 0; !reference.empty(); ++i) {
+        BOOST_REQUIRE_EQUAL(s.nextEffect(), reference.nextEffect());
+        if (i < 1000 && i % 3 == 0) {
+            double d = reference.nextEffect() + dates(gen);
+            s.addEffect(d);
+            reference.addEffect(d);
+        }
+        s.removeNextEffect();
+        reference.removeNextEffect();
+    }
+    BOOST_REQUIRE(s.empty());
+}
+
+BOOST_AUTO_TEST_CASE(calendar_queue_test)
+{
+    compareWithSortedQueue<vemas::CalendarQueue>(1.0);
+    compareWithSortedQueue<vemas::CalendarQueue>(1e6);
+    compareWithSortedQueue<vemas::HeapQueue<4> >(100.0);
+}
+
+BOOST_AUTO_TEST_CASE(calendar_infinity_test)
+{
+    vemas::Scheduler<double, vemas::CalendarQueue> s;
+
+    s.addEffect(vd::infinity);
+    s.addEffect(2.0);
+    BOOST_REQUIRE_EQUAL(s.nextEffect(), 2.0);
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextEffect(), vd::infinity);
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(cancel_test)
+{
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> > s;
+
+    s.setCompactionThreshold(0.6);
+    s.addEffect(vemas::Effect(1.0, "collision", "ball1"));
+    s.addEffect(vemas::Effect(1.0, "collision", "ball2"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball3"));
+    s.addEffect(vemas::Effect(3.0, "collision", "ball4"));
+    s.addEffect(vemas::Effect(4.0, "collision", "ball5"));
+
+    /* Not at the top: kept as a tombstone */
+    BOOST_REQUIRE(s.cancel(vemas::Effect(0.0, "collision", "ball4")));
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 1u);
+    BOOST_REQUIRE_EQUAL(s.size(), 4u);
+    BOOST_REQUIRE(!s.exists(vemas::Effect(0.0, "collision", "ball4")));
+    BOOST_REQUIRE(!s.cancel(vemas::Effect(0.0, "collision", "ball4")));
+
+    /* At the top: purged, first elements follow */
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+    BOOST_REQUIRE(s.cancel(vemas::Effect(0.0, "collision", "ball1")));
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 1u);
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball2");
+
+    s.removeNextEffect();
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball5");
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 0u);
+
+    /* Cancelled identity can be scheduled again */
+    s.addEffect(vemas::Effect(5.0, "collision", "ball4"));
+    BOOST_REQUIRE_EQUAL(s.size(), 2u);
+
+    /* Above the threshold: compaction */
+    s.addEffect(vemas::Effect(6.0, "collision", "ball6"));
+    s.cancel(vemas::Effect(0.0, "collision", "ball6"));
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 1u);
+    s.cancel(vemas::Effect(0.0, "collision", "ball4"));
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 0u);
+    BOOST_REQUIRE_EQUAL(s.size(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball5");
+
+    /* By identity, without building an effect */
+    typedef vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> >::Identity
+        Identity;
+    BOOST_REQUIRE(!s.cancel(Identity("collision", "ball4")));
+    BOOST_REQUIRE(s.cancel(Identity("collision", "ball5")));
+    BOOST_REQUIRE(s.empty());
+    BOOST_REQUIRE(s.firstElements().empty());
+}
+
+template <typename Queue>
+void checkTransformAll()
+{
+    vemas::Scheduler<vemas::Effect, Queue> s;
+
+    for (int i = 0; i < 50; ++i)
+        s.addEffect(vemas::Effect(i, "collision",
+                                  "ball" + std::to_string(i)));
+    s.cancel(vemas::Effect(0.0, "collision", "ball10"));
+
+    /* Reverse the dates: ball49 becomes the first one */
+    s.transformAll([&s](vemas::Effect& e) {
+                       BOOST_REQUIRE_EQUAL(s.elements().size(), 49u);
+                       e.setDate(100.0 - e.getDate());
+                   });
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 0u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball49");
+
+    /* Cancel every even ball */
+    size_t n = s.cancelIf([](const vemas::Effect& e) {
+                              return ((int)e.getDate()) % 2 == 0;
+                          });
+    BOOST_REQUIRE_EQUAL(n, 24u);
+    BOOST_REQUIRE_EQUAL(s.size(), 25u);
+    vd::Time last = 0.0;
+    while (!s.empty()) {
+        BOOST_REQUIRE(s.nextEffect().getDate() > last);
+        BOOST_REQUIRE(((int)s.nextEffect().getDate()) % 2 == 1);
+        last = s.nextEffect().getDate();
+        s.removeNextEffect();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transform_all_test)
+{
+    checkTransformAll<vemas::SortedQueue>();
+    checkTransformAll<vemas::HeapQueue<4> >();
+    checkTransformAll<vemas::CalendarQueue>();
+}
+
+BOOST_AUTO_TEST_CASE(first_elements_test)
+{
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> > s;
+
+    s.addEffect(vemas::Effect(2.0, "collision", "ball1"));
+    s.addEffect(vemas::Effect(3.0, "collision", "ball2"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball3"));
+    s.addEffect(vemas::Effect(3.0, "collision", "ball4"));
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+
+    /* Leaving the first date */
+    s.update(vemas::Effect(4.0, "collision", "ball1"));
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 1u);
+    BOOST_REQUIRE_EQUAL(s.firstElements()[0]->getOrigin(), "ball3");
+
+    /* The last one leaves: the next date is collected */
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.firstElements()[0]->getDate(), 3.0);
+
+    /* Joining the first date */
+    s.update(vemas::Effect(3.0, "collision", "ball1"));
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 3u);
+
+    std::vector<vemas::Effect> popped = s.popAllAt(2.0);
+    BOOST_REQUIRE(popped.empty());
+    popped = s.popAllAt(3.0);
+    BOOST_REQUIRE_EQUAL(popped.size(), 3u);
+    BOOST_REQUIRE(s.empty());
+    BOOST_REQUIRE(s.firstElements().empty());
+    BOOST_REQUIRE(!s.exists(popped[0]));
+}
+
+template <typename Queue>
+void checkTieBreak()
+{
+    typedef vemas::Scheduler<vemas::Effect, Queue,
+                             vemas::DateOf<vemas::Effect>,
+                             vemas::IdentityOf<vemas::Effect>,
+                             vemas::IdentityTieBreak<vemas::Effect> >
+        TieBreakScheduler;
+    TieBreakScheduler s;
+
+    s.addEffect(vemas::Effect(1.0, "collision", "ball3"));
+    s.addEffect(vemas::Effect(1.0, "collision", "ball1"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball0"));
+    s.addEffect(vemas::Effect(1.0, "collision", "ball2"));
+
+    typename TieBreakScheduler::FirstElements first = s.firstElements();
+    BOOST_REQUIRE_EQUAL(first.size(), 3u);
+    BOOST_REQUIRE_EQUAL(first[0]->getOrigin(), "ball1");
+    BOOST_REQUIRE_EQUAL(first[1]->getOrigin(), "ball2");
+    BOOST_REQUIRE_EQUAL(first[2]->getOrigin(), "ball3");
+
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball1");
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball2");
+
+    std::vector<vemas::Effect> popped = s.popAllAt(1.0);
+    BOOST_REQUIRE_EQUAL(popped.size(), 2u);
+    BOOST_REQUIRE_EQUAL(popped[0].getOrigin(), "ball2");
+    BOOST_REQUIRE_EQUAL(popped[1].getOrigin(), "ball3");
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball0");
+}
+
+BOOST_AUTO_TEST_CASE(tie_break_test)
+{
+    checkTieBreak<vemas::SortedQueue>();
+    checkTieBreak<vemas::HeapQueue<4> >();
+    checkTieBreak<vemas::CalendarQueue>();
+}
+
+BOOST_AUTO_TEST_CASE(radix_heap_test)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<vemas::Tick> ticks(0, 1000);
+    vemas::Scheduler<vemas::Tick> reference;
+    vemas::Scheduler<vemas::Tick, vemas::RadixHeapQueue> s;
+
+    for (int i = 0; i < 2000; ++i) {
+        vemas::Tick k = ticks(gen);
+        if (!reference.exists(k)) {
+            reference.addEffect(k);
+            s.addEffect(k);
+        }
+    }
+    for (int i = 0; !reference.empty(); ++i) {
+        BOOST_REQUIRE_EQUAL(s.nextEffect(), reference.nextEffect());
+        vemas::Tick k = reference.nextEffect() + ticks(gen);
+        if (i < 1000 && !reference.exists(k)) {
+            s.addEffect(k);
+            reference.addEffect(k);
+        }
+        s.removeNextEffect();
+        reference.removeNextEffect();
+    }
+    BOOST_REQUIRE(s.empty());
+
+    /* Keys below the last removed minimum are accepted */
+    vemas::RadixHeapQueue q;
+    q.push(0, 10);
+    q.push(1, 20);
+    q.pop();
+    q.push(2, 5);
+    q.push(3, -3);
+    BOOST_REQUIRE_EQUAL(q.top(), 3u);
+    q.pop();
+    BOOST_REQUIRE_EQUAL(q.top(), 2u);
+    q.pop();
+    BOOST_REQUIRE_EQUAL(q.top(), 1u);
+    BOOST_REQUIRE_EQUAL(q.topKey(), 20);
+}
+
+BOOST_AUTO_TEST_CASE(tick_test)
+{
+    typedef vemas::TickTime<1000> Millis;
+    BOOST_REQUIRE_EQUAL(Millis::toTick(1.2344), 1234);
+    BOOST_REQUIRE_EQUAL(Millis::toTick(-1.2346), -1235);
+    BOOST_REQUIRE_EQUAL(Millis::toTime(1500), 1.5);
+    BOOST_REQUIRE_EQUAL(Millis::toTime(Millis::toTick(vd::infinity)),
+                        vd::infinity);
+
+    /* Dates in the same tick are simultaneous */
+    vemas::Scheduler<vemas::Effect, vemas::RadixHeapQueue,
+                     vemas::TickDateOf<vemas::Effect, Millis> > s;
+    s.addEffect(vemas::Effect(1.0001, "collision", "ball1"));
+    s.addEffect(vemas::Effect(0.9999, "collision", "ball2"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball3"));
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.nextKey(), 1000);
+    BOOST_REQUIRE_EQUAL(s.nextDate(), 1.0);
+    BOOST_REQUIRE_EQUAL(s.popAllAt(s.nextKey()).size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.nextDate(), 2.0);
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextDate(), vd::infinity);
+}
+
+BOOST_AUTO_TEST_CASE(tolerance_test)
+{
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> > s;
+    s.setTolerance(1e-6);
+
+    s.addEffect(vemas::Effect(1.0 + 9e-7, "collision", "ball1"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball2"));
+    s.addEffect(vemas::Effect(1.0, "collision", "ball3"));
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball3");
+
+    /* An earlier element moves the window back */
+    s.addEffect(vemas::Effect(1.0 - 5e-7, "collision", "ball4"));
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+
+    /* The head leaves: the window moves forward */
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+
+    std::vector<vemas::Effect> popped = s.popAllAt(s.nextKey());
+    BOOST_REQUIRE_EQUAL(popped.size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.size(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball2");
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_test)
+{
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> > s;
+    for (int i = 0; i < 10; ++i) {
+        vemas::Effect e(i, "collision", "ball" + std::to_string(i));
+        e.add("x", new vv::Double(i));
+        s.addEffect(e);
+    }
+
+    /* The snapshot isn't affected by the modifications made while it is
+     * iterated */
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> >::Elements
+        snapshot = s.elements();
+    const vemas::Effect* first = &snapshot[0];
+    int seen = 0;
+    for (const vemas::Effect& e : snapshot) {
+        s.cancel(e);
+        if (seen % 2 == 0)
+            s.addEffect(vemas::Effect(e.getDate() + 10, "sync",
+                                      e.getOrigin()));
+        ++seen;
+    }
+    BOOST_REQUIRE_EQUAL(seen, 10);
+    BOOST_REQUIRE_EQUAL(snapshot.size(), 10u);
+    BOOST_REQUIRE_EQUAL(s.size(), 5u);
+    BOOST_REQUIRE_EQUAL(&snapshot[0], first);
+    BOOST_REQUIRE_EQUAL(snapshot[0].getName(), "collision");
+
+    /* Elements are shared, not copied, and copied only when changed */
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> >::Elements
+        after = s.elements();
+    const vemas::Effect* shared = &after[0];
+    BOOST_REQUIRE_EQUAL(&s.elements()[0], shared);
+    vemas::Effect changed = after[0];
+    changed.setDate(100);
+    s.update(changed);
+    BOOST_REQUIRE_EQUAL(after[0].getDate(), shared->getDate());
+    BOOST_REQUIRE(&s.get(s.handle(changed)) != shared);
+    BOOST_REQUIRE_EQUAL(s.get(s.handle(changed)).getDate(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(stats_test)
+{
+    vemas::Scheduler<vemas::Effect> s;
+
+    s.addEffect(vemas::Effect(0.0, "move", "ball1"));
+    s.addEffect(vemas::Effect(1.0, "collision", "ball2"));
+    s.addEffect(vemas::Effect(vd::infinity, "collision", "ball3"));
+    s.update(vemas::Effect(3.0, "collision", "ball2"));
+    s.removeNextEffect();
+    s.cancel(vemas::Effect(0.0, "collision", "ball3"));
+    s.addEffect(vemas::Effect(vd::infinity, "collision", "ball4"));
+
+    /* Always maintained */
+    vemas::SchedulerStats stats = s.stats();
+    BOOST_REQUIRE_EQUAL(stats.infinite, 1u);
+    BOOST_REQUIRE_EQUAL(stats.tombstones, 0u);
+    BOOST_REQUIRE_EQUAL(s.size(), 2u);
+    BOOST_REQUIRE_EQUAL(vemas::SchedulerStats::binOf(2.0),
+                        vemas::SchedulerStats::binOf(3.0));
+
+    /* Counted with cmake -DWITH_SCHEDULER_STATS=ON only */
+    if (!vemas::SchedulerStats::enabled)
+        return;
+    BOOST_REQUIRE_EQUAL(stats.inserts, 4u);
+    BOOST_REQUIRE_EQUAL(stats.updates, 1u);
+    BOOST_REQUIRE_EQUAL(stats.removes, 1u);
+    BOOST_REQUIRE_EQUAL(stats.cancels, 1u);
+    BOOST_REQUIRE_EQUAL(stats.peakSize, 3u);
+    BOOST_REQUIRE_EQUAL(stats.rekeys, 0u);
+
+    /* Horizons: 0 (now), 1, infinity, 3, infinity */
+    BOOST_REQUIRE_EQUAL(stats.horizons[0], 1u);
+    BOOST_REQUIRE_EQUAL(stats.horizons[vemas::SchedulerStats::binOf(1.0)],
+                        1u);
+    BOOST_REQUIRE_EQUAL(stats.horizons[vemas::SchedulerStats::binOf(3.0)],
+                        1u);
+    BOOST_REQUIRE_EQUAL(stats.horizons.back(), 2u);
+
+    /* Re-dating every element rebuilds the queue order once */
+    s.transformAll([](vemas::Effect&) {});
+    BOOST_REQUIRE_EQUAL(s.stats().rekeys, 1u);
+}
+
+template <typename Queue>
+void checkParking()
+{
+    vemas::Scheduler<vemas::Effect, Queue> s;
+
+    s.addEffect(vemas::Effect(vd::infinity, "neighbor", "bird1"));
+    s.addEffect(vemas::Effect(vd::infinity, "neighbor", "bird2"));
+    BOOST_REQUIRE_EQUAL(s.parked(), 2u);
+    BOOST_REQUIRE_EQUAL(s.nextDate(), vd::infinity);
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+
+    /* Back in the queue with a finite date */
+    s.update(vemas::Effect(2.0, "neighbor", "bird1"));
+    BOOST_REQUIRE_EQUAL(s.parked(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "bird1");
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 1u);
+
+    /* Parked again */
+    s.update(vemas::Effect(vd::infinity, "neighbor", "bird1"));
+    BOOST_REQUIRE_EQUAL(s.parked(), 2u);
+    BOOST_REQUIRE_EQUAL(s.firstElements().size(), 2u);
+
+    /* Cancelling a parked element leaves no tombstone */
+    BOOST_REQUIRE(s.cancel(vemas::Effect(0.0, "neighbor", "bird2")));
+    BOOST_REQUIRE_EQUAL(s.tombstones(), 0u);
+    BOOST_REQUIRE_EQUAL(s.parked(), 1u);
+
+    s.addEffect(vemas::Effect(1.0, "neighbor", "bird3"));
+    s.transformAll([](vemas::Effect& e) {
+                       e.setDate(e.getDate() == vd::infinity ? 4.0
+                                                             : vd::infinity);
+                   });
+    BOOST_REQUIRE_EQUAL(s.parked(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "bird1");
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "bird3");
+    BOOST_REQUIRE_EQUAL(s.popAllAt(s.nextKey()).size(), 1u);
+    BOOST_REQUIRE(s.empty());
+    BOOST_REQUIRE_EQUAL(s.parked(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(parking_test)
+{
+    checkParking<vemas::SortedQueue>();
+    checkParking<vemas::HeapQueue<4> >();
+    checkParking<vemas::CalendarQueue>();
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel_test)
+{
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<vemas::Tick> ticks(0, 1000000);
+    vemas::Scheduler<vemas::Tick> reference;
+    vemas::Scheduler<vemas::Tick, vemas::TimingWheelQueue> s;
+
+    for (int i = 0; i < 2000; ++i) {
+        vemas::Tick k = ticks(gen);
+        if (!reference.exists(k)) {
+            reference.addEffect(k);
+            s.addEffect(k);
+        }
+    }
+    for (int i = 0; !reference.empty(); ++i) {
+        BOOST_REQUIRE_EQUAL(s.nextEffect(), reference.nextEffect());
+        vemas::Tick k = reference.nextEffect() + ticks(gen) % (1 << (i % 24));
+        if (i < 1000 && !reference.exists(k)) {
+            s.addEffect(k);
+            reference.addEffect(k);
+        }
+        s.removeNextEffect();
+        reference.removeNextEffect();
+    }
+    BOOST_REQUIRE(s.empty());
+
+    /* Keys below the current time are accepted */
+    vemas::TimingWheelQueue q;
+    q.push(0, 100);
+    q.push(1, 5000);
+    q.pop();
+    q.push(2, 70);
+    q.update(1, -3);
+    BOOST_REQUIRE_EQUAL(q.top(), 1u);
+    q.pop();
+    BOOST_REQUIRE_EQUAL(q.top(), 2u);
+    BOOST_REQUIRE_EQUAL(q.topKey(), 70);
+}
+
+BOOST_AUTO_TEST_CASE(periodic_test)
+{
+    typedef vemas::TickTime<1000> Millis;
+    vemas::Scheduler<vemas::Effect, vemas::TimingWheelQueue,
+                     vemas::TickDateOf<vemas::Effect, Millis> > s;
+    vemas::Effect update(1.0, "updateAccordingNeighborhood", "bird1");
+    update.add("speed", vv::Double::create(2.0));
+    std::size_t h = s.schedulePeriodic(update, 1.5);
+    s.addEffect(vemas::Effect(2.5, "enterAgain", "bird1"));
+    BOOST_REQUIRE_THROW(s.schedulePeriodic(vemas::Effect(1.0, "a", "b"), 0),
+                        std::logic_error);
+    BOOST_REQUIRE(s.periodic(h));
+
+    /* The periodic effect keeps its handle and its properties */
+    const vemas::Effect* stored = &s.get(h);
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.nextHandle(), h);
+    BOOST_REQUIRE_EQUAL(&s.get(h), stored);
+    BOOST_REQUIRE_EQUAL(s.get(h).getDate(), 2.5);
+    BOOST_REQUIRE(s.get(h).exists("speed"));
+
+    /* Popped with the other effects of its date, and re-armed */
+    std::vector<vemas::Effect> popped = s.popAllAt(s.nextKey());
+    BOOST_REQUIRE_EQUAL(popped.size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.size(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextDate(), 4.0);
+    if (vemas::SchedulerStats::enabled)
+        BOOST_REQUIRE_EQUAL(s.stats().rearms, 2u);
+
+    /* A shared element outlives its cancellation */
+    std::shared_ptr<const vemas::Effect> alive = s.share(h);
+    BOOST_REQUIRE_EQUAL(alive.get(), &s.get(h));
+    s.cancel(update);
+    BOOST_REQUIRE(s.empty());
+    BOOST_REQUIRE(!s.periodic(h));
+    BOOST_REQUIRE(alive->exists("speed"));
+}
+
+BOOST_AUTO_TEST_CASE(periodic_parked_test)
+{
+    vemas::Scheduler<vemas::Effect, vemas::HeapQueue<4> > s;
+    std::size_t h = s.schedulePeriodic(
+        vemas::Effect(1.0, "updateAccordingNeighborhood", "bird1"), 1.0);
+    s.schedulePeriodic(vemas::Effect(1.0, "observe", "bird1"), 2.0);
+
+    /* Parked at infinity, a periodic effect is popped once, then retired */
+    s.update(h, vemas::Effect(vd::infinity, "updateAccordingNeighborhood",
+                              "bird1"));
+    BOOST_REQUIRE_EQUAL(s.parked(), 1u);
+    s.removeNextEffect();
+    BOOST_REQUIRE_EQUAL(s.nextDate(), 3.0);
+    BOOST_REQUIRE(s.cancel(vemas::Effect(3.0, "observe", "bird1")));
+    BOOST_REQUIRE_EQUAL(s.nextDate(), vd::infinity);
+    std::vector<vemas::Effect> popped = s.popAllAt(s.nextKey());
+    BOOST_REQUIRE_EQUAL(popped.size(), 1u);
+    BOOST_REQUIRE(s.empty());
+    BOOST_REQUIRE(!s.periodic(h));
+    BOOST_REQUIRE_EQUAL(s.parked(), 0u);
+
+    /* as when it is re-armed by hand, or removed as the next effect */
+    h = s.schedulePeriodic(vemas::Effect(vd::infinity, "a", "b"), 1.0);
+    s.rearm(h);
+    BOOST_REQUIRE(s.empty());
+    s.schedulePeriodic(vemas::Effect(vd::infinity, "a", "b"), 1.0);
+    s.removeNextEffect();
+    BOOST_REQUIRE(s.empty());
+}
+
+BOOST_AUTO_TEST_CASE(typed_effect_test)
+{
+    typedef vemas::TypedEffect<vemas::EffectSchema<Wall, Speed, Count> >
+        Collision;
+    vemas::Scheduler<Collision, vemas::HeapQueue<4> > s;
+
+    Collision e(2.0, "doCollision", "ball1");
+    e.set<Wall>(true);
+    e.set<Speed>(1.5);
+    s.addEffect(e);
+    e.setDate(1.0);
+    e.set<Speed>(3.0);
+    s.update(e);
+    BOOST_REQUIRE_EQUAL(s.size(), 1u);
+    BOOST_REQUIRE_EQUAL(s.nextEffect().get<Speed>(), 3.0);
+    BOOST_REQUIRE(s.nextEffect().get<Wall>());
+    BOOST_REQUIRE_EQUAL(s.nextEffect().get<Count>(), 0);
+
+    /* Fields are still readable by name */
+    BOOST_REQUIRE(e.exists("Speed"));
+    BOOST_REQUIRE(!e.exists("speed"));
+    BOOST_REQUIRE_EQUAL(e.get("Speed")->toDouble().value(), 3.0);
+    BOOST_REQUIRE(e.get("Wall")->toBoolean().value());
+    BOOST_REQUIRE_THROW(e.get("speed"), std::logic_error);
+    BOOST_REQUIRE_EQUAL(e.properties().size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(symbol_test)
+{
+    vemas::Symbol empty;
+    vemas::Symbol a("collision");
+    vemas::Symbol b(std::string("colli") + "sion");
+    BOOST_REQUIRE_EQUAL(empty.id(), 0u);
+    BOOST_REQUIRE(empty.empty());
+    BOOST_REQUIRE(a == b);
+    BOOST_REQUIRE_EQUAL(a.id(), b.id());
+    BOOST_REQUIRE_EQUAL(&a.str(), &b.str());
+    BOOST_REQUIRE(a != vemas::Symbol("Collision"));
+
+    std::size_t count = vemas::Symbol::count();
+    vemas::Symbol("collision");
+    BOOST_REQUIRE_EQUAL(vemas::Symbol::count(), count);
+
+    /* Effects and properties are keyed on symbols, strings still work */
+    vemas::Effect e(1.0, "collision", "ball1");
+    e.add("x", vv::Double::create(2.0));
+    BOOST_REQUIRE(e.getNameSymbol() == a);
+    BOOST_REQUIRE_EQUAL(e.getName(), "collision");
+    BOOST_REQUIRE(e.exists(vemas::Symbol("x")));
+    BOOST_REQUIRE_EQUAL(e.get("x")->toDouble().value(), 2.0);
+    BOOST_REQUIRE(e == vemas::Effect(2.0, a, vemas::Symbol("ball1")));
+}
+
+BOOST_AUTO_TEST_CASE(property_container_test)
+{
+    vemas::PropertyContainer p;
+    p.add("x", 1.5);
+    p.add("n", 3);
+    p.add("wall", true);
+    p.add("origin", "ball1");
+    p.add("dy", vv::Double::create(-2.0));
+    p.add("list", vv::Tuple::create(2, 1.0));
+    BOOST_REQUIRE_EQUAL(p.size(), 6u);
+
+    /* Scalars are stored unboxed, other values are kept */
+    BOOST_REQUIRE_EQUAL(p.begin()->first, vemas::Symbol("x"));
+    BOOST_REQUIRE(p.get("dy")->isDouble());
+    BOOST_REQUIRE_EQUAL(p.get("dy")->toDouble().value(), -2.0);
+    BOOST_REQUIRE_EQUAL(p.get("n")->toInteger().value(), 3);
+    BOOST_REQUIRE(p.get("wall")->toBoolean().value());
+    BOOST_REQUIRE_EQUAL(p.get("origin")->toString().value(), "ball1");
+    BOOST_REQUIRE_EQUAL(p.get("list")->toTuple().size(), 2u);
+    BOOST_REQUIRE_THROW(p.get("y"), std::logic_error);
+
+    /* Replacing keeps a single entry */
+    p.add("x", 2.5);
+    BOOST_REQUIRE_EQUAL(p.size(), 6u);
+    BOOST_REQUIRE_EQUAL(p.get("x")->toDouble().value(), 2.5);
+
+    /* Beyond the inline capacity, every property is still found */
+    for (int i = 0; i < 40; ++i)
+        p.add("key" + std::to_string(i), (double)i);
+    vemas::PropertyContainer copy(p);
+    BOOST_REQUIRE_EQUAL(copy.size(), 46u);
+    for (int i = 0; i < 40; ++i)
+        BOOST_REQUIRE_EQUAL(copy.get("key" + std::to_string(i))
+                            ->toDouble().value(), i);
+    BOOST_REQUIRE_EQUAL(copy.get("list")->toTuple().size(), 2u);
+    BOOST_REQUIRE(std::is_sorted(copy.begin(), copy.end(),
+                                 [](const vemas::PropertyContainer::Entry& a,
+                                    const vemas::PropertyContainer::Entry& b) {
+                                     return a.first < b.first;
+                                 }));
+}
+
+BOOST_AUTO_TEST_CASE(property_borrowed_access_test)
+{
+    vemas::PropertyContainer p;
+    p.add("x", 1.5);
+    p.add("n", 3);
+    p.add("wall", true);
+    p.add("origin", "ball1");
+
+    BOOST_REQUIRE_EQUAL(p.getDouble("x"), 1.5);
+    BOOST_REQUIRE_EQUAL(p.getDouble("n"), 3.0);
+    BOOST_REQUIRE_EQUAL(p.getSymbol("origin"), vemas::Symbol("ball1"));
+    BOOST_REQUIRE_THROW(p.getDouble("y"), std::logic_error);
+    BOOST_REQUIRE_THROW(p.getDouble("origin"), std::logic_error);
+    BOOST_REQUIRE_THROW(p.getSymbol("x"), std::logic_error);
+
+    /* find points into the container */
+    const vemas::Property* x = p.find("x");
+    BOOST_REQUIRE(x);
+    BOOST_REQUIRE_EQUAL(x->type(), vemas::Property::DOUBLE);
+    BOOST_REQUIRE(!p.find("y"));
+
+    /* Misses and type mismatches leave the output untouched */
+    double d = -1;
+    std::int64_t n = -1;
+    bool b = false;
+    vemas::Symbol s;
+    BOOST_REQUIRE(!p.tryGet("y", d));
+    BOOST_REQUIRE(!p.tryGet("origin", d));
+    BOOST_REQUIRE_EQUAL(d, -1);
+    BOOST_REQUIRE(!p.tryGet("x", n));
+    BOOST_REQUIRE(p.tryGet("n", n));
+    BOOST_REQUIRE_EQUAL(n, 3);
+    BOOST_REQUIRE(p.tryGet("wall", b));
+    BOOST_REQUIRE(b);
+    BOOST_REQUIRE(p.tryGet("origin", s));
+    BOOST_REQUIRE_EQUAL(s.str(), "ball1");
+}
+
+BOOST_AUTO_TEST_CASE(arena_test)
+{
+    vemas::Arena arena(64);
+    void* a = arena.allocate(3, 1);
+    double* d = static_cast<double*>(arena.allocate(sizeof(double),
+                                                    alignof(double)));
+    BOOST_REQUIRE(a);
+    BOOST_REQUIRE_EQUAL(reinterpret_cast<std::uintptr_t>(d) % alignof(double),
+                        0u);
+
+    /* Aligned blocks near the end of a chunk whose size isn't a multiple
+     * of the alignment */
+    for (std::size_t used = 48; used <= 61; ++used) {
+        vemas::Arena small(61);
+        char* begin = static_cast<char*>(small.allocate(1, 1));
+        for (std::size_t i = 1; i < used; ++i)
+            small.allocate(1, 1);
+        char* block = static_cast<char*>(small.allocate(sizeof(double),
+                                                        alignof(double)));
+        BOOST_REQUIRE_EQUAL(reinterpret_cast<std::uintptr_t>(block)
+                            % alignof(double), 0u);
+        BOOST_REQUIRE(block < begin || block >= begin + used);
+        BOOST_REQUIRE(block + sizeof(double) <= begin + 61
+                      || small.capacity() > 61);
+        *reinterpret_cast<double*>(block) = 1.0;
+    }
+
+    /* Several chunks are merged by the reset */
+    vemas::ArenaAllocator<int> allocator(arena);
+    vemas::ArenaVector<int> v(allocator);
+    for (int i = 0; i < 1000; ++i)
+        v.push_back(i);
+    BOOST_REQUIRE_EQUAL(v[999], 999);
+    std::size_t capacity = arena.capacity();
+    BOOST_REQUIRE(capacity >= 1000 * sizeof(int));
+    v = vemas::ArenaVector<int>(allocator);
+    arena.reset();
+    BOOST_REQUIRE_EQUAL(arena.capacity(), capacity);
+    void* first = arena.allocate(capacity / 2, 1);
+    arena.reset();
+    BOOST_REQUIRE_EQUAL(arena.allocate(1, 1), first);
+
+    /* The scheduler fills a vector of the arena */
+    vemas::Scheduler<vemas::Effect> s;
+    s.addEffect(vemas::Effect(1.0, "collision", "ball1"));
+    s.addEffect(vemas::Effect(1.0, "collision", "ball2"));
+    s.addEffect(vemas::Effect(2.0, "collision", "ball3"));
+    vemas::ArenaAllocator<vemas::Effect> effects(arena);
+    vemas::ArenaVector<vemas::Effect> popped(effects);
+    s.popAllAt(1.0, popped);
+    BOOST_REQUIRE_EQUAL(popped.size(), 2u);
+    BOOST_REQUIRE_EQUAL(s.size(), 1u);
+    BOOST_REQUIRE_EQUAL(arena.capacity(), capacity);
+}
+
+namespace {
+
+struct Counter
+{
+    Counter()
+    :hits(0)
+    {}
+
+    void hit(const vemas::Effect&)
+    {++hits;}
+
+    void miss(const vemas::Effect&)
+    {--hits;}
+
+    int hits;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(effect_table_test)
+{
+    typedef vemas::EffectTable<Counter, vemas::Effect> Table;
+    Table& table = Table::instance();
+    BOOST_REQUIRE_EQUAL(&table, &Table::instance());
+    BOOST_REQUIRE(!table.find("hit"));
+
+    table.add("hit", &Counter::hit);
+    table.add("hit", &Counter::hit);
+    BOOST_REQUIRE(table.find("hit") == &Counter::hit);
+    BOOST_REQUIRE(!table.find("miss"));
+    BOOST_REQUIRE(!table.find(vemas::Symbol()));
+
+    /* One table for every instance */
+    Counter a, b;
+    vemas::Effect e(1.0, "hit", "a");
+    (a.*table.find(e.getNameSymbol()))(e);
+    (b.*table.find(e.getNameSymbol()))(e);
+    (b.*table.find(e.getNameSymbol()))(e);
+    BOOST_REQUIRE_EQUAL(a.hits, 1);
+    BOOST_REQUIRE_EQUAL(b.hits, 2);
+
+    /* A name keeps its method */
+    BOOST_REQUIRE_THROW(table.add("hit", &Counter::miss), std::logic_error);
+    BOOST_REQUIRE(table.find("hit") == &Counter::hit);
+
+    /* Names interned in between don't matter */
+    for (int i = 0; i < 100; ++i)
+        vemas::Symbol("effect_table_key" + std::to_string(i));
+    table.add("effect_table_late", &Counter::miss);
+    BOOST_REQUIRE(table.find("effect_table_late") == &Counter::miss);
+    BOOST_REQUIRE(table.find("hit") == &Counter::hit);
+    BOOST_REQUIRE(!table.find("effect_table_key50"));
+}
+
+BOOST_AUTO_TEST_CASE(move_and_emplace_test)
+{
+    vemas::Scheduler<vemas::Effect> s;
+    vemas::Scheduler<vemas::Effect>::Handle h =
+        s.emplace(2.0, "collision", "ball1");
+    BOOST_REQUIRE_EQUAL(s.get(h).getDate(), 2.0);
+    BOOST_REQUIRE_EQUAL(s.get(h).getOrigin(), "ball1");
+    BOOST_REQUIRE_THROW(s.emplace(3.0, "collision", "ball1"),
+                        std::logic_error);
+
+    vemas::Effect e(1.0, "collision", "ball2");
+    e.add("speed", 4.0);
+    s.addEffect(std::move(e));
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball2");
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getDouble("speed"), 4.0);
+
+    vemas::Effect later(5.0, "collision", "ball2");
+    s.update(std::move(later));
+    BOOST_REQUIRE_EQUAL(s.nextEffect().getOrigin(), "ball1");
+
+    /* A moved in value is kept, not cloned */
+    vemas::PropertyContainer p;
+    vv::Value* tuple = vv::Tuple::create(2, 1.0);
+    p.add("list", std::move(tuple));
+    const vemas::Property* list = p.find("list");
+    BOOST_REQUIRE_EQUAL(&list->getValue(), tuple);
+
+    /* The next effect is popped by move, its values are not cloned */
+    vemas::Effect carrier(0.5, "carry", "ball3");
+    carrier.add("list", vv::Tuple::create(2, 1.0));
+    const vv::Value* carried = &carrier.find("list")->getValue();
+    s.addEffect(std::move(carrier));
+    vemas::Effect popped = s.popNext();
+    BOOST_REQUIRE_EQUAL(&popped.find("list")->getValue(), carried);
+    BOOST_REQUIRE(!s.exists(popped));
+    BOOST_REQUIRE_EQUAL(s.popNext().getOrigin(), "ball1");
+    BOOST_REQUIRE_EQUAL(s.size(), 1u);
+
+    /* Moving a container keeps its properties, inline or not */
+    vemas::PropertyContainer moved(std::move(p));
+    BOOST_REQUIRE(p.empty());
+    BOOST_REQUIRE_EQUAL(&moved.find("list")->getValue(), tuple);
+    for (int i = 0; i < 40; ++i)
+        moved.add("key" + std::to_string(i), (double)i);
+    vemas::PropertyContainer target;
+    target.add("x", 1.0);
+    target = std::move(moved);
+    BOOST_REQUIRE(moved.empty());
+    BOOST_REQUIRE_EQUAL(target.size(), 41u);
+    BOOST_REQUIRE(!target.exists("x"));
+    BOOST_REQUIRE_EQUAL(target.getDouble("key39"), 39.0);
+    BOOST_REQUIRE_EQUAL(&target.find("list")->getValue(), tuple);
+}
+
+MAS_MESSAGE(TestPosition, x, y, radius);
+MAS_MESSAGE(TestBounds, north, south);
+
+BOOST_AUTO_TEST_CASE(typed_message_test)
+{
+    BOOST_REQUIRE_EQUAL(TestPosition::size(), 3u);
+    BOOST_REQUIRE_EQUAL(TestPosition::key().str(), "TestPosition");
+
+    vemas::Message m("ball1", vemas::Message::BROADCAST, "ball_position");
+    TestPosition sent = {1.0, 2.0, 0.5};
+    vemas::encodeMessage(sent, m);
+    BOOST_REQUIRE(m.empty());
+    BOOST_REQUIRE_EQUAL(m.getPayloadKey(), TestPosition::key());
+    BOOST_REQUIRE_EQUAL(m.getPayloadSize(), 3u);
+    BOOST_REQUIRE(vemas::carries<TestPosition>(m));
+    BOOST_REQUIRE(!vemas::carries<TestBounds>(m));
+
+    /* The payload survives a copy, as in the send buffer */
+    vemas::Message copy(m);
+    TestPosition received = vemas::decodeMessage<TestPosition>(copy);
+    BOOST_REQUIRE_EQUAL(received.x, 1.0);
+    BOOST_REQUIRE_EQUAL(received.y, 2.0);
+    BOOST_REQUIRE_EQUAL(received.radius, 0.5);
+    BOOST_REQUIRE_THROW(vemas::decodeMessage<TestBounds>(copy),
+                        std::logic_error);
+
+    /* Copied through the DEVS attributes, it comes back as a tuple */
+    std::unique_ptr<vv::Tuple> attribute(m.payloadToValue());
+    vemas::Message attributes("ball1", "ball2", "ball_position");
+    attributes.add(TestPosition::key(), *attribute);
+    received = vemas::decodeMessage<TestPosition>(attributes);
+    BOOST_REQUIRE_EQUAL(received.y, 2.0);
+
+    /* and a message from another symbol table keeps it inline */
+    vemas::Message rebuilt = vemas::MessageValue::rebuild(m);
+    BOOST_REQUIRE(rebuilt.empty());
+    received = vemas::decodeMessage<TestPosition>(rebuilt);
+    BOOST_REQUIRE_EQUAL(received.radius, 0.5);
+
+    /* A tuple of the wrong size is not a payload */
+    vemas::Message bad("ball1", "ball2", "ball_position");
+    bad.add(TestPosition::key(), vv::Tuple::create(2, 1.0));
+    BOOST_REQUIRE(!vemas::carries<TestPosition>(bad));
+    BOOST_REQUIRE_THROW(vemas::decodeMessage<TestPosition>(bad),
+                        std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(message_value_test)
+{
+    vemas::Message m("ball1", vemas::Message::BROADCAST, "ball_position");
+    m.add("x", 1.0);
+    m.add("origin", "ball1");
+    m.add("list", vv::Tuple::create(2, 1.0));
+    vemas::MessageValue::pointer frozen =
+        std::make_shared<const vemas::Message>(std::move(m));
+
+    /* Every receiver shares the sent message */
+    vemas::MessageValue value(frozen);
+    std::unique_ptr<vv::Value> copy(value.clone());
+    const vemas::MessageValue* received = vemas::MessageValue::cast(*copy);
+    BOOST_REQUIRE(received);
+    BOOST_REQUIRE(received->local());
+    BOOST_REQUIRE_EQUAL(&received->message(), frozen.get());
+    BOOST_REQUIRE_EQUAL(received->localMessage(), frozen);
+    BOOST_REQUIRE(!vemas::MessageValue::cast(vv::Double(1.0)));
+
+    /* A message from another symbol table is rebuilt from the strings */
+    vemas::Message rebuilt = vemas::MessageValue::rebuild(*frozen);
+    BOOST_REQUIRE_EQUAL(rebuilt.getSubject(), "ball_position");
+    BOOST_REQUIRE_EQUAL(rebuilt.getReceiver(), vemas::Message::BROADCAST);
+    BOOST_REQUIRE_EQUAL(rebuilt.size(), 3u);
+    BOOST_REQUIRE_EQUAL(rebuilt.getDouble("x"), 1.0);
+    BOOST_REQUIRE_EQUAL(rebuilt.getSymbol("origin").str(), "ball1");
+    BOOST_REQUIRE_EQUAL(rebuilt.get("list")->toTuple().size(), 2u);
+}
@@ -35,8 +35,6 @@
 #include <vle/extension/mas/collision/Types.hpp>
 #include <vle/extension/mas/collision/Circle.hpp>
 
-#define toDouble(X) X->toDouble().value()
-
 using namespace vle::extension::mas;
 
 namespace mas
@@ -52,12 +50,63 @@ namespace vv = vle::value;
 namespace bg = boost::geometry;
 namespace bn = boost::numeric;
 
-class BallG : public GenericAgent
+/* Message subjects, interned once */
+const Symbol cBallPosition("ball_position");
+const Symbol cCollisionCallback("collision_callback");
+const Symbol cCollision("collision");
+const Symbol cCollisionSync("collision_sync");
+
+/* Effect names */
+const Symbol cDoCollision("doCollision");
+
+/* collision_sync property keys */
+const Symbol cEffect("effect");
+const Symbol cOrigin("origin");
+
+/* Message payloads, a position is sent on ball_position and
+ * collision_callback */
+MAS_MESSAGE(BallPosition, x, y, dx, dy, radius);
+MAS_MESSAGE(WallPosition, x1, y1, x2, y2);
+
+/* Fields of the wall and ball collision effects */
+namespace collision
+{
+MAS_EFFECT_FIELD(Wall, bool);
+MAS_EFFECT_FIELD(X, double);
+MAS_EFFECT_FIELD(Y, double);
+MAS_EFFECT_FIELD(Dx, double);
+MAS_EFFECT_FIELD(Dy, double);
+MAS_EFFECT_FIELD(X1, double);
+MAS_EFFECT_FIELD(Y1, double);
+MAS_EFFECT_FIELD(X2, double);
+MAS_EFFECT_FIELD(Y2, double);
+MAS_EFFECT_FIELD(C2X, double);
+MAS_EFFECT_FIELD(C2Y, double);
+MAS_EFFECT_FIELD(C2Dx, double);
+MAS_EFFECT_FIELD(C2Dy, double);
+MAS_EFFECT_FIELD(C2Radius, double);
+MAS_EFFECT_FIELD(LastUpdate, double);
+
+typedef EffectSchema<Wall, X, Y, Dx, Dy, X1, Y1, X2, Y2,
+                     C2X, C2Y, C2Dx, C2Dy, C2Radius, LastUpdate> Schema;
+}
+
+typedef TypedEffect<collision::Schema> CollisionEffect;
+
+/* Collision dates are compared in ticks, so simultaneous collisions
+ * computed by different balls are exact ties */
+typedef Scheduler<CollisionEffect, RadixHeapQueue,
+                  TickDateOf<CollisionEffect> > BallScheduler;
+
+/* Collisions of the same date, applied in one transition */
+typedef ArenaVector<CollisionEffect> Collisions;
+
+class BallG : public BasicGenericAgent<BallScheduler>
 {
 public:
 
     BallG(const vd::DynamicsInit& init, const vd::InitEventList& events)
-        : GenericAgent(init, events)
+        : BasicGenericAgent(init, events)
     {
         mCircle.getCenter().x(events.exist("x") ? events.getDouble("x"):-1);
         mCircle.getCenter().y(events.exist("y") ? events.getDouble("y"):-1);
@@ -65,9 +114,15 @@ public:
         mDirection.y() = events.exist("dy") ? events.getDouble("dy") : -1;
         mCircle.getRadius() = events.exist("radius")
                               ? events.getDouble("radius"):0;
-
-        addEffect("doCollision",
-                  boost::bind(&BallG::doCollision,this,_1));
+        /* Collisions computed by both balls differ in the last bits */
+        mScheduler.setTolerance(DefaultTickTime::toTick(
+                                    events.exist("tolerance")
+                                    ? events.getDouble("tolerance"):1e-9));
+
+        registerHandler(cBallPosition, &BallG::onBallPosition);
+        registerHandler(cCollisionCallback, &BallG::onBallPosition);
+        registerHandler(cCollision, &BallG::onCollision);
+        registerHandler(cCollisionSync, &BallG::onCollisionSync);
     }
 
 
@@ -79,107 +134,106 @@ protected:
 
     void agent_dynamic()
     {
-        Effect nextEffect = mScheduler.nextEffect();
-
-        applyEffect(nextEffect.getName(),nextEffect);
+        if (mScheduler.empty())
+            return;
+
+        /* Simultaneous collisions are handled together, moved out of the
+         * scheduler; the batch lives until the end of the transition */
+        ArenaAllocator<CollisionEffect> allocator(transientArena());
+        Collisions collisions(allocator);
+        mScheduler.popAllAt(mScheduler.nextKey(), collisions);
+        doCollision(collisions);
     }
 
-    void agent_handleEvent(const Message &message)
+    void onBallPosition(const Message& message)
     {
-        std::string subject = message.getSubject();
         Circle currentCircle = getCurrentCircle();
-        if(subject == "ball_position" || subject == "collision_callback") {
-            double c2_x = toDouble(message.get("x"));
-            double c2_y = toDouble(message.get("y"));
-            double c2_dx = toDouble(message.get("dx"));
-            double c2_dy = toDouble(message.get("dy"));
-            double c2_radius = toDouble(message.get("radius"));
-            double date;
-
-            Point p2(c2_x,c2_y);
-            Vector2d d2(c2_dx,c2_dy);
-            Circle c2(Point(c2_x,c2_y),c2_radius);
-            if(currentCircle.inCollision(mDirection,c2,d2)) {
-
-
-                CollisionPoints cp = currentCircle.collisionPoints(mDirection,
-                                                                   c2,
-                                                                   d2);
-                Vector2d new_direction = currentCircle.newDirection(mDirection,
-                                                                    c2,
-                                                                    d2);
-
-
-                double distance = bg::distance(cp.object1CollisionPosition,
-                                               currentCircle.getCenter());
-
-                double distance2 = bg::distance(cp.object2CollisionPosition,
-                                                c2.getCenter());
-
-
-                double date = (distance / mDirection.norm()) + mCurrentTime;
-
-                double datetr = trunc_doub(date,10);
-
-                double date2 =  trunc_doub((distance2 / d2.norm()) + mCurrentTime, 10);
-
-                double vraidate = (date + date2)/2;
-
-
-                if (datetr <= mCurrentTime)
-                    datetr = mCurrentTime;
-
-                Effect collision = ballCollisionEffect(datetr,
-                                                       message.getSender(),
-                                                       cp.object1CollisionPosition,
-                                                       new_direction,
-                                                       c2_x, c2_y, c2_dx, c2_dy, c2_radius,
-                                                       mCurrentTime);
-                if (!mScheduler.exists(collision))
-                    mScheduler.addEffect(collision);
-                else
-                    mScheduler.update(collision);
-
-                if (subject == "ball_position") {
-                    sendCollisionCallback(message.getSender());
-                }
+        BallPosition ball = decodeMessage<BallPosition>(message);
+        double c2_x = ball.x;
+        double c2_y = ball.y;
+        double c2_dx = ball.dx;
+        double c2_dy = ball.dy;
+        double c2_radius = ball.radius;
+
+        Point p2(c2_x,c2_y);
+        Vector2d d2(c2_dx,c2_dy);
+        Circle c2(Point(c2_x,c2_y),c2_radius);
+        if(currentCircle.inCollision(mDirection,c2,d2)) {
+
+
+            CollisionPoints cp = currentCircle.collisionPoints(mDirection,
+                                                               c2,
+                                                               d2);
+            Vector2d new_direction = currentCircle.newDirection(mDirection,
+                                                                c2,
+                                                                d2);
+
+
+            double distance = bg::distance(cp.object1CollisionPosition,
+                                           currentCircle.getCenter());
+
+            /* Rounded once, to ticks, by the scheduler */
+            double date = (distance / mDirection.norm()) + mCurrentTime;
+
+            if (date <= mCurrentTime)
+                date = mCurrentTime;
+
+            CollisionEffect collision = ballCollisionEffect(date,
+                                                   message.getSenderSymbol(),
+                                                   cp.object1CollisionPosition,
+                                                   new_direction,
+                                                   c2_x, c2_y, c2_dx, c2_dy, c2_radius,
+                                                   mCurrentTime);
+            if (!mScheduler.exists(collision))
+                mScheduler.addEffect(std::move(collision));
+            else
+                mScheduler.update(std::move(collision));
+
+            if (message.getSubjectSymbol() == cBallPosition) {
+                sendCollisionCallback(message.getSenderSymbol());
             }
-        } else if (subject == "collision") {
-            double wall_x1 = toDouble(message.get("wall_x1"));
-            double wall_y1 = toDouble(message.get("wall_y1"));
-            double wall_x2 = toDouble(message.get("wall_x2"));
-            double wall_y2 = toDouble(message.get("wall_y2"));
-
-            Segment s(Point(wall_x1,wall_y1),Point(wall_x2,wall_y2));
-            if(currentCircle.inCollision(s,mDirection)) {
-                CollisionPoints cp = currentCircle.collisionPoints(s,
-                                                                   mDirection);
-                Vector2d new_direction = currentCircle.newDirection(s,
-                                                                   mDirection);
-
-
-                double date = (bg::distance(cp.object1CollisionPosition,
-                                               currentCircle.getCenter())
-                              / mDirection.norm()) + mCurrentTime;
-
-                Effect collision = wallCollisionEffect(date,
-                                                       message.getSender(),
-                                                       cp.object1CollisionPosition,
-                                                       new_direction,wall_x1,wall_y1,wall_x2,wall_y2);
-                if (!mScheduler.exists(collision))
-                    mScheduler.addEffect(collision);
-                else
-                    mScheduler.update(collision);
-            }
-        } else if (subject == "collision_sync") {
-            Effect e(vd::infinity,
-                     message.get("effect")->toString().value(),
-                     message.get("origin")->toString().value());
-            if (mScheduler.exists(e))
-                mScheduler.update(e);
         }
     }
 
+    void onCollision(const Message& message)
+    {
+        Circle currentCircle = getCurrentCircle();
+        WallPosition wall = decodeMessage<WallPosition>(message);
+        double wall_x1 = wall.x1;
+        double wall_y1 = wall.y1;
+        double wall_x2 = wall.x2;
+        double wall_y2 = wall.y2;
+
+        Segment s(Point(wall_x1,wall_y1),Point(wall_x2,wall_y2));
+        if(currentCircle.inCollision(s,mDirection)) {
+            CollisionPoints cp = currentCircle.collisionPoints(s,
+                                                               mDirection);
+            Vector2d new_direction = currentCircle.newDirection(s,
+                                                               mDirection);
+
+
+            double date = (bg::distance(cp.object1CollisionPosition,
+                                           currentCircle.getCenter())
+                          / mDirection.norm()) + mCurrentTime;
+
+            CollisionEffect collision = wallCollisionEffect(date,
+                                                   message.getSenderSymbol(),
+                                                   cp.object1CollisionPosition,
+                                                   new_direction,wall_x1,wall_y1,wall_x2,wall_y2);
+            if (!mScheduler.exists(collision))
+                mScheduler.addEffect(std::move(collision));
+            else
+                mScheduler.update(std::move(collision));
+        }
+    }
+
+    void onCollisionSync(const Message& message)
+    {
+        mScheduler.cancel(EffectScheduler::Identity(
+                              message.getSymbol(cEffect),
+                              message.getSymbol(cOrigin)));
+    }
+
     vv::Value* observation(const vd::ObservationEvent& event) const
     {
         vd::Time delta_t = event.getTime() - mLastUpdate;
@@ -200,7 +254,7 @@ protected:
                          % vu::toScientificString(mCircle.getRadius()));
             return new vv::String(output);
         }
-        return 0;
+        return BasicGenericAgent::observation(event);
     }
 
     /**************************** Utils ***************************************/
@@ -215,41 +269,30 @@ protected:
 
     void sendMyInformation()
     {
-        Message m(getModelName(),Message::BROADCAST,"ball_position");
-
-        m.add("x",vv::Double::create(mCircle.getCenter().x()));
-        m.add("y",vv::Double::create(mCircle.getCenter().y()));
-        m.add("dx",vv::Double::create(mDirection.x()));
-        m.add("dy",vv::Double::create(mDirection.y()));
-        m.add("radius",vv::Double::create(mCircle.getRadius()));
+        BallPosition p = {mCircle.getCenter().x(), mCircle.getCenter().y(),
+                          mDirection.x(), mDirection.y(),
+                          mCircle.getRadius()};
 
-        sendMessage(m);
+        sendMessage(Message::broadcastSymbol(), cBallPosition, p);
     }
 
-    void sendCollisionCallback(const std::string& to)
+    void sendCollisionCallback(const Symbol& to)
     {
         vd::Time delta_t = mCurrentTime - mLastUpdate;
         double x = (mDirection.x() * delta_t) + mCircle.getCenter().x();
         double y = (mDirection.y() * delta_t) + mCircle.getCenter().y();
-        Message m(getModelName(),to,"collision_callback");
-
-        m.add("x",vv::Double::create(x));
-        m.add("y",vv::Double::create(y));
-        m.add("dx",vv::Double::create(mDirection.x()));
-        m.add("dy",vv::Double::create(mDirection.y()));
-        m.add("radius",vv::Double::create(mCircle.getRadius()));
+        BallPosition p = {x, y, mDirection.x(), mDirection.y(),
+                          mCircle.getRadius()};
 
-        sendMessage(m);
+        sendMessage(to, cCollisionCallback, p);
     }
 
-    void sendCollisionSync(const Effect& e)
+    void sendCollisionSync(const CollisionEffect& e)
     {
-        Message m(getModelName(),e.getOrigin(),"collision_sync");
+        Message& m = emplaceMessage(getModelSymbol(),e.getOriginSymbol(),cCollisionSync);
 
-        m.add("effect",vv::String::create(e.getName()));
-        m.add("origin",vv::String::create(getModelName()));
-
-        sendMessage(m);
+        m.add(cEffect,e.getNameSymbol());
+        m.add(cOrigin,getModelSymbol());
     }
 
     /*************************** Effect functions *****************************/
@@ -257,33 +300,29 @@ protected:
      * - It computes collision position.
      * - It updates ball direction.
      * - It sends informative message to all agents after the update. */
-    void doCollision(const Effect& e)
+    void doCollision(const Collisions& collisions)
     {
-        double x =  toDouble(e.get("x"));
-        double y =  toDouble(e.get("y"));
+        const CollisionEffect& e = collisions.front();
+        double x = e.get<collision::X>();
+        double y = e.get<collision::Y>();
         double dx = 0;
         double dy = 0;
 
-        int nEffects = mScheduler.firstElements().size();
-
-        if (nEffects == 1) {
+        if (collisions.size() == 1) {
 
-            dx = toDouble(e.get("dx"));
-            dy = toDouble(e.get("dy"));
+            dx = e.get<collision::Dx>();
+            dy = e.get<collision::Dy>();
 
             /* Apply effect */
             mDirection = Vector2d(dx,dy);
             mCircle.getCenter() = Point(x,y);
         } else {
-            std::vector<Effect*> firstElements = mScheduler.firstElements();
-            for (std::vector<Effect*>::iterator it = firstElements.begin();
-                 it != firstElements.end();
-                 ++it) {
-                if (((*it)->get("type"))->toString().value() == "WALL") {
-                    double x1 = toDouble((*it)->get("x1"));
-                    double y1 = toDouble((*it)->get("y1"));
-                    double x2 = toDouble((*it)->get("x2"));
-                    double y2 = toDouble((*it)->get("y2"));
+            for (const CollisionEffect& c : collisions) {
+                if (c.get<collision::Wall>()) {
+                    double x1 = c.get<collision::X1>();
+                    double y1 = c.get<collision::Y1>();
+                    double x2 = c.get<collision::X2>();
+                    double y2 = c.get<collision::Y2>();
 
                     Segment s(Point(x1,y1),Point(x2,y2));
 
@@ -294,21 +333,19 @@ protected:
                     Vector2d new_direction = currentCircle.newDirection(s,
                                                                         mDirection);
 
-                    double a = angle(mDirection, new_direction);
-
-
                     mDirection = new_direction;
 
                 } else {
-                    double c2_x = toDouble((*it)->get("c2_x"));
-                    double c2_y = toDouble((*it)->get("c2_y"));
-                    double c2_dx = toDouble((*it)->get("c2_dx"));
-                    double c2_dy = toDouble((*it)->get("c2_dy"));
-                    double c2_radius = toDouble((*it)->get("c2_radius"));
+                    double c2_x = c.get<collision::C2X>();
+                    double c2_y = c.get<collision::C2Y>();
+                    double c2_dx = c.get<collision::C2Dx>();
+                    double c2_dy = c.get<collision::C2Dy>();
+                    double c2_radius = c.get<collision::C2Radius>();
 
                     Vector2d d2(c2_dx,c2_dy);
 
-                    double delta_t = mCurrentTime - toDouble((*it)->get("last_update"));
+                    double delta_t = mCurrentTime
+                                     - c.get<collision::LastUpdate>();
 
                     double nc2_x = (c2_dx * delta_t) + c2_x;
                     double nc2_y = (c2_dy * delta_t) + c2_y;
@@ -321,7 +358,6 @@ protected:
                                                                             c2,
                                                                             d2);
 
-                        double a = angle(mDirection, new_direction);
                         mDirection = new_direction;
                     }
                     mCircle.getCenter() = Point(x,y);
@@ -329,66 +365,62 @@ protected:
             }
         }
 
+        /* The direction changed: every collision computed before is stale */
+        for (const CollisionEffect& c : collisions)
+            sendCollisionSync(c);
+        mScheduler.cancelIf([this](const CollisionEffect& effect) {
+                                this->sendCollisionSync(effect);
+                                return true;
+                            });
         /* Send my information */
-        Scheduler<Effect> tmp = mScheduler;
-        std::for_each(tmp.elements().begin(),
-                      tmp.elements().end(),
-                      [this](Effect effect) {
-                          this->sendCollisionSync(effect);
-                          Effect e(vd::infinity,
-                                   effect.getName(),
-                                   effect.getOrigin());
-                          this->mScheduler.update(e);
-                      });
         sendMyInformation();
     }
 
     /**************************** Effect "factory" ****************************/
-    Effect wallCollisionEffect(double t,const std::string& source,
-                               const Point& position,const Vector2d& direction,
-                               double x1, double y1, double x2, double y2)
+    CollisionEffect wallCollisionEffect(double t,const Symbol& source,
+                                        const Point& position,
+                                        const Vector2d& direction,
+                                        double x1, double y1,
+                                        double x2, double y2)
     {
-        Effect effect(t,"doCollision",source);
-
-        effect.add("type",vv::String::create(std::string("WALL")));
-        effect.add("x",vv::Double::create(position.x()));
-        effect.add("y",vv::Double::create(position.y()));
-        effect.add("dx",vv::Double::create(direction.x()));
-        effect.add("dy",vv::Double::create(direction.y()));
-        effect.add("x1",vv::Double::create(x1));
-        effect.add("y1",vv::Double::create(y1));
-        effect.add("x2",vv::Double::create(x2));
-        effect.add("y2",vv::Double::create(y2));
+        CollisionEffect effect(t,cDoCollision,source);
+
+        effect.set<collision::Wall>(true);
+        effect.set<collision::X>(position.x());
+        effect.set<collision::Y>(position.y());
+        effect.set<collision::Dx>(direction.x());
+        effect.set<collision::Dy>(direction.y());
+        effect.set<collision::X1>(x1);
+        effect.set<collision::Y1>(y1);
+        effect.set<collision::X2>(x2);
+        effect.set<collision::Y2>(y2);
 
         return effect;
     }
 
-    Effect ballCollisionEffect(double t,const std::string& source,
-                               const Point& position,const Vector2d& direction,
-                               double c2_x, double c2_y, double c2_dx, double c2_dy, double c2_radius,
-                               double ct)
+    CollisionEffect ballCollisionEffect(double t,const Symbol& source,
+                                        const Point& position,
+                                        const Vector2d& direction,
+                                        double c2_x, double c2_y,
+                                        double c2_dx, double c2_dy,
+                                        double c2_radius, double ct)
     {
-        Effect effect(t,"doCollision",source);
-
-        effect.add("type",vv::String::create(std::string("BALL")));
-        effect.add("x",vv::Double::create(position.x()));
-        effect.add("y",vv::Double::create(position.y()));
-        effect.add("dx",vv::Double::create(direction.x()));
-        effect.add("dy",vv::Double::create(direction.y()));
-        effect.add("c2_x",vv::Double::create(c2_x));
-        effect.add("c2_y",vv::Double::create(c2_y));
-        effect.add("c2_dx",vv::Double::create(c2_dx));
-        effect.add("c2_dy",vv::Double::create(c2_dy));
-        effect.add("c2_radius",vv::Double::create(c2_radius));
-        effect.add("last_update",vv::Double::create(ct));
+        CollisionEffect effect(t,cDoCollision,source);
+
+        effect.set<collision::Wall>(false);
+        effect.set<collision::X>(position.x());
+        effect.set<collision::Y>(position.y());
+        effect.set<collision::Dx>(direction.x());
+        effect.set<collision::Dy>(direction.y());
+        effect.set<collision::C2X>(c2_x);
+        effect.set<collision::C2Y>(c2_y);
+        effect.set<collision::C2Dx>(c2_dx);
+        effect.set<collision::C2Dy>(c2_dy);
+        effect.set<collision::C2Radius>(c2_radius);
+        effect.set<collision::LastUpdate>(ct);
 
         return effect;
     }
-
-    double trunc_doub(double val, int precision)
-    {
-        return floorf(val * pow(10.0f,precision) + .5f)/pow(10.0f,precision);
-    }
 private:
     Circle   mCircle;
     Vector2d mDirection;
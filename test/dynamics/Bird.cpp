@@ -42,8 +42,6 @@
 #include <vle/extension/mas/collision/Types.hpp>
 #include <vle/extension/mas/collision/Circle.hpp>
 
-#define toDouble(X) X->toDouble().value()
-
 using namespace vle::extension::mas;
 
 typedef boost::geometry::model::linestring<Point> Line;
@@ -61,6 +59,28 @@ namespace vv = vle::value;
 namespace bg = boost::geometry;
 namespace bn = boost::numeric;
 
+/* Message subjects, interned once */
+const Symbol cEnterAgain("enterAgain");
+const Symbol cBirdPosition("birdPosition");
+const Symbol cAskBirdPosition("askBirdPosition");
+
+/* Effect names */
+const Symbol cEnterAgainEffect("enterAgain");
+const Symbol cUpdateAccordingNeighborhood("updateAccordingNeighborhood");
+const Symbol cEnterOrLeaveNeighborhood("enterOrLeaveNeighborhood");
+
+/* Effect property keys */
+const Symbol cNewX("newX");
+const Symbol cNewY("newY");
+const Symbol cX("x");
+const Symbol cY("y");
+const Symbol cDx("dx");
+const Symbol cDy("dy");
+
+/* Message payloads */
+MAS_MESSAGE(BirdPosition, x, y, dx, dy, radius);
+MAS_MESSAGE(SkyBounds, north, south, east, west);
+
 class BirdInfo
 {
 public:
@@ -76,12 +96,13 @@ public:
     double mYDirection;
 };
 
-class Bird : public GenericAgent
+class Bird : public BasicGenericAgent<Scheduler<Effect, TimingWheelQueue,
+                                                TickDateOf<Effect> > >
 {
 public:
 
     Bird(const vd::DynamicsInit& init, const vd::InitEventList& events)
-        : GenericAgent(init, events)
+        : BasicGenericAgent(init, events)
     {
         mCircle.getCenter().x(events.exist("x") ? events.getDouble("x"):-1);
         mCircle.getCenter().y(events.exist("y") ? events.getDouble("y"):-1);
@@ -94,14 +115,17 @@ public:
         mMaxSeparateTurn  = events.exist("maxSeparateTurn") ? events.getDouble("maxSeparateTurn") : 3;
         mMaxAlignTurn  = events.exist("maxAlignTurn") ? events.getDouble("maxAlignTurn") : 5;
 
-        addEffect("enterAgain",
-                  boost::bind(&Bird::enterAgain,this,_1));
+        addEffect(cEnterAgainEffect, &Bird::enterAgain);
 
-        addEffect("updateAccordingNeighborhood",
-                  boost::bind(&Bird::updateAccordingNeighborhood,this,_1));
+        addEffect(cUpdateAccordingNeighborhood,
+                  &Bird::updateAccordingNeighborhood);
 
-        addEffect("enterOrLeaveNeighborhood",
-                   boost::bind(&Bird::enterOrLeaveNeighborhood,this,_1));
+        addEffect(cEnterOrLeaveNeighborhood,
+                  &Bird::enterOrLeaveNeighborhood);
+
+        registerHandler(cEnterAgain, &Bird::onEnterAgain);
+        registerHandler(cBirdPosition, &Bird::onBirdPosition);
+        registerHandler(cAskBirdPosition, &Bird::onAskBirdPosition);
     }
 
 
@@ -110,191 +134,186 @@ protected:
     {
         sendBirdInformation();
 
-        Effect update = updateAccordingNeighborhoodEffect(mCurrentTime + 1,
-                                                          getModelName()+"toto");
-
-        mScheduler.addEffect(update);
-
+        schedulePeriodic(cUpdateAccordingNeighborhood, 1.5, 1);
     }
 
     void agent_dynamic()
     {
-        Effect nextEffect = mScheduler.nextEffect();
-
-        applyEffect(nextEffect.getName(),nextEffect);
+        applyNextEffect();
     }
 
-    void agent_handleEvent(const Message &message)
+    void onEnterAgain(const Message& message)
     {
-        std::string subject = message.getSubject();
-        if(subject == "enterAgain") {
-            double north = toDouble(message.get("north"));
-            double south = toDouble(message.get("south"));
-            double east = toDouble(message.get("east"));
-            double west = toDouble(message.get("west"));
+        SkyBounds sky = decodeMessage<SkyBounds>(message);
+        double north = sky.north;
+        double south = sky.south;
+        double east = sky.east;
+        double west = sky.west;
 
-            // calcul de la + grande dimension du ciel + une marge
-            Vector2d diag(north - south, east - west);
+        // calcul de la + grande dimension du ciel + une marge
+        Vector2d diag(north - south, east - west);
 
-            double bigDim = diag.norm() + 11;
+        double bigDim = diag.norm() + 11;
 
-            // on calcul le point d'intersection
+        // on calcul le point d'intersection
 
-            Vector2d dirBird = mDirection.normalize();
+        Vector2d dirBird = mDirection.normalize();
 
-            Circle currentBird = getCurrentCircle();
+        Circle currentBird = getCurrentCircle();
 
-            double xOutside = currentBird.getCenter().x() +  dirBird.x() * bigDim;
-            double yOutside = currentBird.getCenter().y() +  dirBird.y() * bigDim;
+        double xOutside = currentBird.getCenter().x() +  dirBird.x() * bigDim;
+        double yOutside = currentBird.getCenter().y() +  dirBird.y() * bigDim;
 
-            Line trajectoire;
+        Line trajectoire;
 
-            // La trajectoire
-            trajectoire.push_back(Point(currentBird.getCenter().x(), currentBird.getCenter().y()));
+        // La trajectoire
+        trajectoire.push_back(Point(currentBird.getCenter().x(), currentBird.getCenter().y()));
 
-            trajectoire.push_back(Point(xOutside, yOutside));
+        trajectoire.push_back(Point(xOutside, yOutside));
 
-            //Le ciel
-            Line ciel;
+        //Le ciel
+        Line ciel;
 
-            ciel.push_back(Point(east , north));
-            ciel.push_back(Point(west, north));
-            ciel.push_back(Point(west, south));
-            ciel.push_back(Point(east, south));
-            ciel.push_back(Point(east, north));
+        ciel.push_back(Point(east , north));
+        ciel.push_back(Point(west, north));
+        ciel.push_back(Point(west, south));
+        ciel.push_back(Point(east, south));
+        ciel.push_back(Point(east, north));
 
-            // intersection
-            std::vector<Point> intersection;
-            boost::geometry::intersection(trajectoire, ciel, intersection);
-            // durée
+        // intersection
+        ArenaAllocator<Point> allocator(transientArena());
+        ArenaVector<Point> intersection(allocator);
+        boost::geometry::intersection(trajectoire, ciel, intersection);
+        // durée
 
-            Vector2d centerWall(intersection.at(0).x()-currentBird.getCenter().x(),
-                                intersection.at(0).y()-currentBird.getCenter().y());
+        Vector2d centerWall(intersection.at(0).x()-currentBird.getCenter().x(),
+                            intersection.at(0).y()-currentBird.getCenter().y());
 
-            double centerWallDistance = centerWall.norm();
+        double centerWallDistance = centerWall.norm();
 
-            double date = (centerWallDistance / mDirection.norm()) + mCurrentTime;
+        double date = (centerWallDistance / mDirection.norm()) + mCurrentTime;
 
-            if (date <= mCurrentTime)
-                date = mCurrentTime;
+        if (date <= mCurrentTime)
+            date = mCurrentTime;
 
-            // La trajectoire opposée
-            Line trajectoireOpposee;
-            xOutside = currentBird.getCenter().x() +  (-dirBird.x() * bigDim);
-            yOutside = currentBird.getCenter().y() +  (-dirBird.y() * bigDim);
-            double xBirdMoreInside = (currentBird.getCenter().x() +  intersection.at(0).x())/2;
-            double yBirdMoreInside = (currentBird.getCenter().y() +  intersection.at(0).y())/2;
+        // La trajectoire opposée
+        Line trajectoireOpposee;
+        xOutside = currentBird.getCenter().x() +  (-dirBird.x() * bigDim);
+        yOutside = currentBird.getCenter().y() +  (-dirBird.y() * bigDim);
+        double xBirdMoreInside = (currentBird.getCenter().x() +  intersection.at(0).x())/2;
+        double yBirdMoreInside = (currentBird.getCenter().y() +  intersection.at(0).y())/2;
 
-            // La trajectoire
-            trajectoireOpposee.push_back(Point(xBirdMoreInside, yBirdMoreInside));
-            trajectoireOpposee.push_back(Point(xOutside, yOutside));
-            // intersection
-            std::vector<Point> intersectionOpposee;
-             //Le ciel intérieur
-            Line interieurCiel;
+        // La trajectoire
+        trajectoireOpposee.push_back(Point(xBirdMoreInside, yBirdMoreInside));
+        trajectoireOpposee.push_back(Point(xOutside, yOutside));
+        // intersection
+        ArenaVector<Point> intersectionOpposee(allocator);
+         //Le ciel intérieur
+        Line interieurCiel;
 
-            interieurCiel.push_back(Point(east + 0.1, north + 0.1));
-            interieurCiel.push_back(Point(west - 0.1, north + 0.1));
-            interieurCiel.push_back(Point(west - 0.1, south - 0.1));
-            interieurCiel.push_back(Point(east + 0.1, south - 0.1));
-            interieurCiel.push_back(Point(east + 0.1, north + 0.1));
+        interieurCiel.push_back(Point(east + 0.1, north + 0.1));
+        interieurCiel.push_back(Point(west - 0.1, north + 0.1));
+        interieurCiel.push_back(Point(west - 0.1, south - 0.1));
+        interieurCiel.push_back(Point(east + 0.1, south - 0.1));
+        interieurCiel.push_back(Point(east + 0.1, north + 0.1));
 
-            boost::geometry::intersection(trajectoireOpposee, interieurCiel, intersectionOpposee);
+        boost::geometry::intersection(trajectoireOpposee, interieurCiel, intersectionOpposee);
 
-            double xInterOp, yInterOp;
+        double xInterOp, yInterOp;
 
-            if (intersectionOpposee.size() == 2 ) {
-                if( Vector2d(intersectionOpposee.at(0).x() - xBirdMoreInside,
-                             intersectionOpposee.at(0).y() - yBirdMoreInside ).norm()
-                    < Vector2d(intersectionOpposee.at(1).x() - xBirdMoreInside,
-                               intersectionOpposee.at(1).y() - yBirdMoreInside).norm()) {
-                    xInterOp = intersectionOpposee.at(1).x();
-                    yInterOp = intersectionOpposee.at(1).y();
-                } else {
-                    xInterOp = intersectionOpposee.at(0).x();
-                    yInterOp = intersectionOpposee.at(0).y();
-                }
+        if (intersectionOpposee.size() == 2 ) {
+            if( Vector2d(intersectionOpposee.at(0).x() - xBirdMoreInside,
+                         intersectionOpposee.at(0).y() - yBirdMoreInside ).norm()
+                < Vector2d(intersectionOpposee.at(1).x() - xBirdMoreInside,
+                           intersectionOpposee.at(1).y() - yBirdMoreInside).norm()) {
+                xInterOp = intersectionOpposee.at(1).x();
+                yInterOp = intersectionOpposee.at(1).y();
             } else {
                 xInterOp = intersectionOpposee.at(0).x();
                 yInterOp = intersectionOpposee.at(0).y();
             }
+        } else {
+            xInterOp = intersectionOpposee.at(0).x();
+            yInterOp = intersectionOpposee.at(0).y();
+        }
 
-            Effect enterAgain = enterAgainEffect(date,
-                                                 message.getSender(),
-                                                 xInterOp,
-                                                 yInterOp);
-
+        Effect enterAgain = enterAgainEffect(date,
+                                             message.getSenderSymbol(),
+                                             xInterOp,
+                                             yInterOp);
 
-            if (!mScheduler.exists(enterAgain))
-                mScheduler.addEffect(enterAgain);
-            else
-                mScheduler.update(enterAgain);
-        } else if (subject == "birdPosition") {
-            double x = toDouble(message.get("x"));
-            double y = toDouble(message.get("y"));
-            double dx = toDouble(message.get("dx"));
-            double dy = toDouble(message.get("dy"));
-
-            //update the voisinage
-            std::map< std::string, BirdInfo* >::const_iterator it;
-            it = mVoisinage.find(message.getSender());
-
-            //TODO
-            if (it != mVoisinage.end() )
-            {
-                ((*it).second)->mX = x;
-                ((*it).second)->mY = y;
-                ((*it).second)->mXDirection = dx;
-                ((*it).second)->mYDirection = dy;
-            }
 
-            // first we need when and if a collision will occur
+        if (!mScheduler.exists(enterAgain))
+            mScheduler.addEffect(std::move(enterAgain));
+        else
+            mScheduler.update(std::move(enterAgain));
+    }
 
-            Point p(x,y);
-            Vector2d d(dx, dy);
-            Circle c(p,0);
+    void onBirdPosition(const Message& message)
+    {
+        BirdPosition bird = decodeMessage<BirdPosition>(message);
+        double x = bird.x;
+        double y = bird.y;
+        double dx = bird.dx;
+        double dy = bird.dy;
+
+        //update the voisinage
+        std::map< std::string, BirdInfo* >::const_iterator it;
+        it = mVoisinage.find(message.getSender());
+
+        //TODO
+        if (it != mVoisinage.end() )
+        {
+            ((*it).second)->mX = x;
+            ((*it).second)->mY = y;
+            ((*it).second)->mXDirection = dx;
+            ((*it).second)->mYDirection = dy;
+        }
 
-            Circle voisinage(getCurrentCircle().getCenter(), 5);
+        // first we need when and if a collision will occur
 
-            if(voisinage.inCollision(mDirection,c,d)) {
-                CollisionPoints cp = voisinage.collisionPoints(mDirection,
-                                                               c,
-                                                               d);
+        Point p(x,y);
+        Vector2d d(dx, dy);
+        Circle c(p,0);
 
-                double distance = bg::distance(cp.object1CollisionPosition,
-                                               getCurrentCircle().getCenter());
+        Circle voisinage(getCurrentCircle().getCenter(), 5);
 
+        if(voisinage.inCollision(mDirection,c,d)) {
+            CollisionPoints cp = voisinage.collisionPoints(mDirection,
+                                                           c,
+                                                           d);
 
-                double date = (distance / mDirection.norm()) + mCurrentTime;
+            double distance = bg::distance(cp.object1CollisionPosition,
+                                           getCurrentCircle().getCenter());
 
-                Effect enterOrLeaveNeighborhood = enterOrLeaveNeighborhoodEffect(date,
-                                                                                 message.getSender(),
-                                                                                 x, y, dx, dy);
 
-                if (!mScheduler.exists(enterOrLeaveNeighborhood))
-                    mScheduler.addEffect(enterOrLeaveNeighborhood);
-                else
-                    mScheduler.update(enterOrLeaveNeighborhood);
+            double date = (distance / mDirection.norm()) + mCurrentTime;
 
-            } else {
-                if (mVoisinage.find((message.getSender())) != mVoisinage.end()) {
-                    mVoisinage.erase(message.getSender());
-                }
+            Effect enterOrLeaveNeighborhood = enterOrLeaveNeighborhoodEffect(date,
+                                                                             message.getSenderSymbol(),
+                                                                             x, y, dx, dy);
 
-                Effect enterOrLeaveNeighborhood = enterOrLeaveNeighborhoodEffect(vd::infinity,
-                                                                                 message.getSender(),
-                                                                                 x, y, dx, dy);
+            if (!mScheduler.exists(enterOrLeaveNeighborhood))
+                mScheduler.addEffect(std::move(enterOrLeaveNeighborhood));
+            else
+                mScheduler.update(std::move(enterOrLeaveNeighborhood));
 
-                if (!mScheduler.exists(enterOrLeaveNeighborhood))
-                    mScheduler.addEffect(enterOrLeaveNeighborhood);
-                else
-                    mScheduler.update(enterOrLeaveNeighborhood);
+        } else {
+            if (mVoisinage.find((message.getSender())) != mVoisinage.end()) {
+                mVoisinage.erase(message.getSender());
             }
-        } else if (subject == "askBirdPosition") {
-            sendCurrentBirdInformation();
+
+            mScheduler.cancel(EffectScheduler::Identity(
+                                  cEnterOrLeaveNeighborhood,
+                                  message.getSenderSymbol()));
         }
     }
 
+    void onAskBirdPosition(const Message& message)
+    {
+        sendCurrentBirdInformation();
+    }
+
     vv::Value* observation(const vd::ObservationEvent& event) const
     {
         vd::Time delta_t = event.getTime() - mLastUpdate;
@@ -315,7 +334,7 @@ protected:
                          % vu::toScientificString(mCircle.getRadius()));
             return new vv::String(output);
         }
-        return 0;
+        return BasicGenericAgent::observation(event);
     }
 
     /**************************** Utils ***************************************/
@@ -330,35 +349,26 @@ protected:
 
     void sendBirdInformation()
     {
-        Message m(getModelName(),Message::BROADCAST,"birdPosition");
-
-        m.add("x",vv::Double::create(mCircle.getCenter().x()));
-        m.add("y",vv::Double::create(mCircle.getCenter().y()));
-        m.add("dx",vv::Double::create(mDirection.x()));
-        m.add("dy",vv::Double::create(mDirection.y()));
-        m.add("radius",vv::Double::create(mCircle.getRadius()));
+        BirdPosition p = {mCircle.getCenter().x(), mCircle.getCenter().y(),
+                          mDirection.x(), mDirection.y(),
+                          mCircle.getRadius()};
 
-        sendMessage(m);
+        sendMessage(Message::broadcastSymbol(), cBirdPosition, p);
     }
 
     void sendCurrentBirdInformation()
     {
-        Message m(getModelName(),Message::BROADCAST,"birdPosition");
+        Circle current = getCurrentCircle();
+        BirdPosition p = {current.getCenter().x(), current.getCenter().y(),
+                          mDirection.x(), mDirection.y(),
+                          mCircle.getRadius()};
 
-        m.add("x",vv::Double::create(getCurrentCircle().getCenter().x()));
-        m.add("y",vv::Double::create(getCurrentCircle().getCenter().y()));
-        m.add("dx",vv::Double::create(mDirection.x()));
-        m.add("dy",vv::Double::create(mDirection.y()));
-        m.add("radius",vv::Double::create(mCircle.getRadius()));
-
-        sendMessage(m);
+        sendMessage(Message::broadcastSymbol(), cBirdPosition, p);
     }
 
-    void sendAskForInformation(const std::string& to)
+    void sendAskForInformation(const Symbol& to)
     {
-        Message m(getModelName(),to,"askBirdPosition");
-
-        sendMessage(m);
+        emplaceMessage(getModelSymbol(),to,cAskBirdPosition);
     }
 
     /*************************** Effect functions *****************************/
@@ -366,13 +376,13 @@ protected:
      * - It does enable to renter the sky*/
     void enterAgain(const Effect& e)
     {
-        double x =  toDouble(e.get("newX"));
-        double y =  toDouble(e.get("newY"));
+        double x =  e.getDouble(cNewX);
+        double y =  e.getDouble(cNewY);
 
         mCircle.getCenter() = Point(x,y);
 
         sendBirdInformation();
-        sendAskForInformation(Message::BROADCAST);
+        sendAskForInformation(Message::broadcastSymbol());
     }
 
     void updateAccordingNeighborhood(const Effect& e)
@@ -463,30 +473,20 @@ protected:
             }
 
             sendBirdInformation();
-            sendAskForInformation(Message::BROADCAST);
+            sendAskForInformation(Message::broadcastSymbol());
         } else {
              mCircle = getCurrentCircle();
         }
-
-
-        Effect update = updateAccordingNeighborhoodEffect(mCurrentTime + 1.5,
-                                                          getModelName()+"toto");
-
-        mScheduler.update(update);
     }
 
     void enterOrLeaveNeighborhood(const Effect& e)
     {
         mCircle = getCurrentCircle();
-        Effect effect(vd::infinity,
-                      e.getName(),
-                      e.getOrigin());
-        this->mScheduler.update(effect);
 
-        double x = toDouble(e.get("x"));
-        double y = toDouble(e.get("y"));
-        double dx = toDouble(e.get("dx"));
-        double dy = toDouble(e.get("dy"));
+        double x = e.getDouble(cX);
+        double y = e.getDouble(cY);
+        double dx = e.getDouble(cDx);
+        double dy = e.getDouble(cDy);
 
         if (mVoisinage.find((e.getOrigin())) != mVoisinage.end()) {
             mVoisinage.erase(e.getOrigin());
@@ -496,34 +496,26 @@ protected:
     }
 
     /**************************** Effect "factory" ****************************/
-    Effect enterAgainEffect(double t,const std::string& source, double x, double y)
+    Effect enterAgainEffect(double t,const Symbol& source, double x, double y)
     {
-        Effect effect(t,"enterAgain",source);
+        Effect effect(t,cEnterAgainEffect,source);
 
-        effect.add("newX",vv::Double::create(x));
-        effect.add("newY",vv::Double::create(y));
+        effect.add(cNewX,x);
+        effect.add(cNewY,y);
 
         return effect;
     }
 
-    Effect enterOrLeaveNeighborhoodEffect(double t,const std::string& source,
+    Effect enterOrLeaveNeighborhoodEffect(double t,const Symbol& source,
                                           double x, double y,
                                           double dx, double dy)
     {
-        Effect effect(t,"enterOrLeaveNeighborhood",source);
+        Effect effect(t,cEnterOrLeaveNeighborhood,source);
 
-        effect.add("x",vv::Double::create(x));
-        effect.add("y",vv::Double::create(y));
-        effect.add("dx",vv::Double::create(dx));
-        effect.add("dy",vv::Double::create(dy));
-
-        return effect;
-    }
-
-    /**************************** Effect "factory" ****************************/
-    Effect updateAccordingNeighborhoodEffect(double t,const std::string& source)
-    {
-        Effect effect(t,"updateAccordingNeighborhood",source);
+        effect.add(cX,x);
+        effect.add(cY,y);
+        effect.add(cDx,dx);
+        effect.add(cDy,dy);
 
         return effect;
     }
@@ -30,9 +30,12 @@
 #include <vle/devs/Executive.hpp>
 #include <vle/value/Map.hpp>
 
+#include <vle/extension/mas/RoutedExecutive.hpp>
+
 namespace vd = vle::devs;
 namespace vv = vle::value;
 namespace vp = vle::vpz;
+namespace vemas = vle::extension::mas;
 
 namespace mas
 {
@@ -41,13 +44,13 @@ namespace test
 namespace dynamics
 {
 
-class ExecuterWallBall : public vd::Executive
+class ExecuterWallBall : public vemas::RoutedExecutive
 {
 public:
     typedef std::vector<std::string> Strings;
     ExecuterWallBall(const vd::ExecutiveInit& init,
                      const vd::InitEventList& events)
-    : vd::Executive(init, events),mWallNumbers(0),mBallNumbers(0)
+    : vemas::RoutedExecutive(init, events),mWallNumbers(0),mBallNumbers(0)
     {
         mView = "view1";
 
@@ -64,6 +67,8 @@ public:
 
     vd::Time init(const vd::Time&)
     {
+        createRouter();
+
         createWall(0, 0, 0, 40);
         createWall(0, 40, 100, 40);
         createWall(100, 0, 100, 40);
@@ -152,8 +157,7 @@ public:
                     "dyn_wall",
                     Strings({wall_cond.name()}),
                     "");
-        connect("wall" + id);
-        mModels.push_back("wall" + id);
+        connectAgent("wall" + id);
         ++mWallNumbers;
     }
 
@@ -194,30 +198,13 @@ public:
             addObservableToView("ball" + id, it, mView);
 
         //Connect to others
-        connect("ball" + id);
-        mModels.push_back("ball" + id);
+        connectAgent("ball" + id);
 
         ++mBallNumbers;
     }
-
-    void connect(const std::string& new_agent)
-    {
-        for (auto existing_agent : mModels)
-        {
-            addConnection(new_agent,
-                          "agent_output",
-                          existing_agent,
-                          "agent_input");
-            addConnection(existing_agent,
-                          "agent_output",
-                          new_agent,
-                          "agent_input");
-        }
-    }
 private:
     int mWallNumbers;
     int mBallNumbers;
-    Strings mModels;
     std::string mView;
 };
 
@@ -31,6 +31,8 @@
 #include <vle/value/Map.hpp>
 #include <vle/utils/Rand.hpp>
 
+#include <vle/extension/mas/RoutedExecutive.hpp>
+
 #include<math.h>
 
 #include <vle/extension/mas/collision/Vector2d.hpp>
@@ -38,6 +40,7 @@
 namespace vd = vle::devs;
 namespace vv = vle::value;
 namespace vp = vle::vpz;
+namespace vemas = vle::extension::mas;
 namespace vu = vle::utils;
 
 namespace mas
@@ -47,13 +50,13 @@ namespace test
 namespace dynamics
 {
 
-class God : public vd::Executive
+class God : public vemas::RoutedExecutive
 {
 public:
     typedef std::vector<std::string> Strings;
     God(const vd::ExecutiveInit& init,
                      const vd::InitEventList& events)
-    : vd::Executive(init, events),mBirdNumbers(0)
+    : vemas::RoutedExecutive(init, events),mBirdNumbers(0)
     {
 
         // Les limites du ciel
@@ -92,6 +95,8 @@ public:
 
     vd::Time init(const vd::Time&)
     {
+        createRouter();
+
         createSky(mNorth, mSouth, mEast, mWest);
 
         for(int i = 1; i <= mPopulation; ++i){
@@ -140,8 +145,7 @@ public:
                     "dynSky",
                     Strings({wall_cond.name()}),
                     "");
-        connect("Sky");
-        mModels.push_back("Sky");
+        connectAgent("Sky");
     }
 
     void createBird(double x, double y, double dx, double dy, double radius)
@@ -181,8 +185,7 @@ public:
             addObservableToView("bird" + id, it, mView);
 
         //Connect to others
-        connect("bird" + id);
-        mModels.push_back("bird" + id);
+        connectAgent("bird" + id);
 
         // keep the coordinates also
         mKeepCoordinates["bird" + id] = std::array< double, 3 > {x,y,radius};
@@ -209,25 +212,8 @@ public:
         }
         return false;
     }
-
-
-    void connect(const std::string& new_agent)
-    {
-        for (auto existing_agent : mModels)
-        {
-            addConnection(new_agent,
-                          "agent_output",
-                          existing_agent,
-                          "agent_input");
-            addConnection(existing_agent,
-                          "agent_output",
-                          new_agent,
-                          "agent_input");
-        }
-    }
 private:
     int mBirdNumbers;
-    Strings mModels;
     std::string mView;
 
     typedef std::map< std::string, std::array<double, 3>> KeepCordinates;
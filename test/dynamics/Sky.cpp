@@ -53,6 +53,13 @@ namespace vv = vle::value;
 namespace bg = boost::geometry;
 namespace bn = boost::numeric;
 
+/* Message subjects, interned once */
+const Symbol cBirdPosition("birdPosition");
+const Symbol cEnterAgain("enterAgain");
+
+/* Message payloads */
+MAS_MESSAGE(SkyBounds, north, south, east, west);
+
 class Sky : public GenericAgent
 {
 public:
@@ -63,29 +70,24 @@ public:
         mSouth = events.exist("south") ? events.getDouble("south") : -1;
         mEast = events.exist("east") ? events.getDouble("east") : -1;
         mWest = events.exist("west") ? events.getDouble("west") : -1;
+
+        registerHandler(cBirdPosition, &Sky::onBirdPosition);
     }
 
     void agent_init() {}
 
     void agent_dynamic() {}
 
-    void agent_handleEvent(const Message& message)
+    void onBirdPosition(const Message& message)
     {
-        if (message.getSubject() == "birdPosition") {
-            sendEnterAgainEvent(message.getSender());
-        }
+        sendEnterAgainEvent(message.getSenderSymbol());
     }
 
-    void sendEnterAgainEvent(const std::string& ball_name)
+    void sendEnterAgainEvent(const Symbol& ball_name)
     {
-        Message m(getModelName(),ball_name,"enterAgain");
-
-        m.add("north",vv::Double::create(mNorth));
-        m.add("south",vv::Double::create(mSouth));
-        m.add("east",vv::Double::create(mEast));
-        m.add("west",vv::Double::create(mWest));
+        SkyBounds bounds = {mNorth, mSouth, mEast, mWest};
 
-        sendMessage(m);
+        sendMessage(ball_name, cEnterAgain, bounds);
     }
 
 private:
@@ -52,6 +52,14 @@ namespace vv = vle::value;
 namespace bg = boost::geometry;
 namespace bn = boost::numeric;
 
+/* Message subjects, interned once */
+const Symbol cBallPosition("ball_position");
+const Symbol cCollision("collision");
+
+/* Message payloads */
+MAS_MESSAGE(BallPosition, x, y, dx, dy, radius);
+MAS_MESSAGE(WallPosition, x1, y1, x2, y2);
+
 class WallG : public GenericAgent
 {
 public:
@@ -65,39 +73,36 @@ public:
 
         mSegment.setEnd1(x1);
         mSegment.setEnd2(x2);
+
+        registerHandler(cBallPosition, &WallG::onBallPosition);
     }
 
     void agent_init() {}
 
     void agent_dynamic() {}
 
-    void agent_handleEvent(const Message& message)
+    void onBallPosition(const Message& message)
     {
-        if (message.getSubject() == "ball_position") {
-            double dx = message.get("dx")->toDouble().value();
-            double dy = message.get("dy")->toDouble().value();
-            double c_x = message.get("x")->toDouble().value();
-            double c_y = message.get("y")->toDouble().value();
-            double radius = message.get("radius")->toDouble().value();
-            Vector2d v_ball(dx,dy);
-            Circle circle(Point(c_x,c_y),radius);
-
-            if(circle.inCollision(mSegment,v_ball)) {
-                sendCollisionEvent(message.getSender());
-            }
+        BallPosition ball = decodeMessage<BallPosition>(message);
+        double dx = ball.dx;
+        double dy = ball.dy;
+        double c_x = ball.x;
+        double c_y = ball.y;
+        double radius = ball.radius;
+        Vector2d v_ball(dx,dy);
+        Circle circle(Point(c_x,c_y),radius);
+
+        if(circle.inCollision(mSegment,v_ball)) {
+            sendCollisionEvent(message.getSenderSymbol());
         }
     }
 
-    void sendCollisionEvent(const std::string& ball_name)
+    void sendCollisionEvent(const Symbol& ball_name)
     {
-        Message m(getModelName(),ball_name,"collision");
-
-        m.add("wall_x1",vv::Double::create(mSegment.getEnd1().x()));
-        m.add("wall_y1",vv::Double::create(mSegment.getEnd1().y()));
-        m.add("wall_x2",vv::Double::create(mSegment.getEnd2().x()));
-        m.add("wall_y2",vv::Double::create(mSegment.getEnd2().y()));
+        WallPosition wall = {mSegment.getEnd1().x(), mSegment.getEnd1().y(),
+                             mSegment.getEnd2().x(), mSegment.getEnd2().y()};
 
-        sendMessage(m);
+        sendMessage(ball_name, cCollision, wall);
     }
 
 private: